@@ -6,4 +6,4 @@ END.
 
 // Error Test 3: Syntax - Missing Semicolon
 // Tests if the parser reports a syntax error when a semicolon is missing between statements.
-// Expected Error(s): Syntax Error (L:4, C:3): syntax error
\ No newline at end of file
+// Expected Error(s): Syntax Error (L:4, C:10): syntax error, unexpected identifier, expecting END or ';'
\ No newline at end of file
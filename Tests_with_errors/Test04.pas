@@ -5,4 +5,4 @@ END
 
 // Error Test 4: Syntax - Missing Program Period
 // Tests if the parser reports an error if the final 'END.' is missing its period.
-// Expected Error(s): Syntax Error (L:8, C:61): syntax error
\ No newline at end of file
+// Expected Error(s): Syntax Error (L:8, C:101): syntax error, unexpected end of file, expecting '.'
\ No newline at end of file
@@ -5,4 +5,4 @@ END.
 
 // Error Test 5: Syntax - Missing Parenthesis in Call
 // Tests for a syntax error when a function call with arguments is missing a closing parenthesis.
-// Expected Error(s): Syntax Error (L:3, C:18): syntax error
\ No newline at end of file
+// Expected Error(s): Syntax Error (L:3, C:19): syntax error, unexpected ';', expecting ',' or ')'
\ No newline at end of file
@@ -13,5 +13,7 @@ Error Test 9: Mixed Lexical, Syntax, and Semantic Errors
 Tests the compiler's ability to handle a cascade of different error types.
 Expected Error(s):
 Lexical Error (L:6, C:16): Unexpected character '%'
-Syntax Error (L:4, C:19): syntax error
+Syntax Error (L:4, C:19): syntax error, unexpected BOOLEAN, expecting ',' or ':'
+Syntax Error (L:6, C:19): syntax error, unexpected integer literal, expecting END or ';'
+Semantic Error (L:8, C:5): Identifier 'result' is not declared.
 }
\ No newline at end of file
@@ -11,6 +11,6 @@ END.
 Error Test 11: Multiple Syntax Errors
 Tests the parser's ability to report multiple syntax issues.
 Expected Error(s):
-Syntax Error (L:3, C:12): syntax error
-
+Syntax Error (L:3, C:12): syntax error, unexpected INTEGER, expecting ',' or ':'
+Syntax Error (L:5, C:16): syntax error, unexpected ';', expecting ')'
 }
\ No newline at end of file
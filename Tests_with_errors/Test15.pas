@@ -0,0 +1,17 @@
+PROGRAM LiteralRange1;
+VAR
+  x: INTEGER;
+  r: REAL;
+BEGIN
+  x := 99999999999999999999; // Error: too big for any integer
+  r := 1e999; // Error: too big for a real
+END.
+
+{
+Error Test 15: Lexical - Numeric Literals Out of Range
+Tests if the lexer rejects literals that can't be converted at all. Both are
+reported in one run, and the compilation stops before parsing.
+Expected Error(s):
+Lexical Error (L:6, C:8): Integer literal '99999999999999999999' is out of range
+Lexical Error (L:7, C:8): Real literal '1e999' is out of range
+}
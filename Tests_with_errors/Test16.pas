@@ -0,0 +1,17 @@
+PROGRAM LiteralRange2;
+VAR
+  x: INTEGER;
+BEGIN
+  x := 3000000000; // Error: does not fit in an INTEGER
+  x := -2147483648; // Fine: the smallest INTEGER
+  x := -2147483649 // Error: one below it
+END.
+
+{
+Error Test 16: Semantic - Integer Literals Out of Range
+Tests if the analyzer rejects integer literals that lex fine but don't fit in
+an INTEGER. A negated literal is checked together with its minus sign.
+Expected Error(s):
+Semantic Error (L:5, C:8): Integer literal 3000000000 is out of range for type integer (at most 2147483647).
+Semantic Error (L:7, C:9): Integer literal 2147483649 is out of range for type integer (at most 2147483648 after the minus sign).
+}
@@ -0,0 +1,26 @@
+PROGRAM MultiSyntax;
+VAR
+  x: INTEGER;
+
+FUNCTION Twice(a: INTEGER) INTEGER; // Error: missing ':' before the return type
+BEGIN
+  RETURN a * 2
+END;
+
+BEGIN
+  x := 1;
+  x := x + ; // Error: missing operand
+  x := TRUE; // Error: found by semantic analysis of the recovered tree
+  writeln(x)
+END.
+
+{
+Error Test 17: Syntax - Recovery After Several Errors
+Tests if the parser recovers from a broken function head and reports the later
+statement error in the same run, and if semantic analysis then still runs on
+the rest of the program.
+Expected Error(s):
+Syntax Error (L:5, C:35): syntax error, unexpected INTEGER, expecting ':'
+Syntax Error (L:12, C:13): syntax error, unexpected ';'
+Semantic Error (L:13, C:13): Type mismatch in assignment to 'x'. Cannot assign type Boolean to variable of type Integer.
+}
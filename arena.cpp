@@ -0,0 +1,56 @@
+#include "arena.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+Arena::~Arena() {
+    release();
+}
+
+void Arena::release() {
+    while (blocks) {
+        Block* next = blocks->next;
+        std::free(blocks);
+        blocks = next;
+    }
+    cursor = nullptr;
+    limit = nullptr;
+    used = 0;
+    reserved = 0;
+}
+
+void* Arena::allocateSlow(size_t size, size_t align) {
+    // The header keeps the block start max-aligned; 'align' more bytes cover
+    // any stricter alignment.
+    size_t needed = size + align;
+    bool dedicated = needed > BLOCK_SIZE / 4;
+    size_t blockSize = dedicated ? needed : BLOCK_SIZE;
+
+    Block* block = static_cast<Block*>(std::malloc(sizeof(Block) + blockSize));
+    if (!block) throw std::bad_alloc();
+    block->size = blockSize;
+    reserved += blockSize;
+    char* begin = reinterpret_cast<char*>(block + 1);
+
+    uintptr_t start = (reinterpret_cast<uintptr_t>(begin) + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    used += size;
+    if (dedicated && blocks) {
+        // Slot it in behind the current block, which keeps serving small requests.
+        block->next = blocks->next;
+        blocks->next = block;
+    }
+    else {
+        block->next = blocks;
+        blocks = block;
+        cursor = reinterpret_cast<char*>(start + size);
+        limit = begin + blockSize;
+    }
+    return reinterpret_cast<void*>(start);
+}
+
+std::string_view Arena::copy(std::string_view text) {
+    if (text.empty()) return std::string_view();
+    char* storage = static_cast<char*>(allocate(text.size(), 1));
+    std::memcpy(storage, text.data(), text.size());
+    return std::string_view(storage, text.size());
+}
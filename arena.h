@@ -0,0 +1,60 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Bump-pointer allocator for everything that lives exactly as long as one
+// compilation: the AST and the storage behind its lists. Allocating is a
+// pointer bump inside the current block. Nothing is freed on its own and destructors of objects placed
+// here never run, so they must not own memory outside the arena; the whole lot
+// is dropped at once by release() or the destructor.
+class Arena {
+private:
+    struct Block {
+        Block* next;
+        size_t size; // usable bytes following the header
+    };
+
+    Block* blocks = nullptr; // most recently added first
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t used = 0;
+    size_t reserved = 0;
+
+    void* allocateSlow(size_t size, size_t align);
+
+public:
+    // Allocations bigger than a quarter of this get a block of their own
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    Arena() = default;
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // 'align' must be a power of two
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        uintptr_t start = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~static_cast<uintptr_t>(align - 1);
+        if (cursor && start + size <= reinterpret_cast<uintptr_t>(limit)) {
+            cursor = reinterpret_cast<char*>(start + size);
+            used += size;
+            return reinterpret_cast<void*>(start);
+        }
+        return allocateSlow(size, align);
+    }
+
+    // Copies 'text' into the arena
+    std::string_view copy(std::string_view text);
+
+    // Frees every block at once; whatever was allocated here is gone.
+    void release();
+
+    // Bytes handed out / bytes obtained from the system
+    size_t bytesUsed() const { return used; }
+    size_t bytesReserved() const { return reserved; }
+};
+
+#endif // ARENA_H
@@ -0,0 +1,70 @@
+#include "artifact_store.h"
+#include <cstdio>
+
+// --- FileArtifactStore ---
+
+FileArtifactStore::FileArtifactStore(std::string directory, std::string baseName)
+    : dir(std::move(directory)), base_name(std::move(baseName)) {}
+
+std::ostream* FileArtifactStore::open(const std::string& suffix) {
+    auto file = std::make_unique<std::ofstream>(location(suffix));
+    if (!*file) return nullptr;
+    std::ostream* stream = file.get();
+    files[suffix] = std::move(file);
+    return stream;
+}
+
+void FileArtifactStore::close(const std::string& suffix) {
+    files.erase(suffix); // ofstream's destructor flushes and closes
+}
+
+std::unique_ptr<CodeSink> FileArtifactStore::openSink(const std::string& suffix) {
+    auto sink = std::make_unique<FileCodeSink>(location(suffix));
+    if (!sink->isOpen()) return nullptr;
+    return sink;
+}
+
+void FileArtifactStore::discard(const std::string& suffix) {
+    files.erase(suffix);
+    std::remove(location(suffix).c_str());
+}
+
+std::string FileArtifactStore::location(const std::string& suffix) const {
+    return dir + "/" + base_name + suffix;
+}
+
+// --- MemoryArtifactStore ---
+
+MemoryArtifactStore::MemoryArtifactStore(std::string directory, std::string baseName)
+    : dir(std::move(directory)), base_name(std::move(baseName)) {}
+
+std::ostream* MemoryArtifactStore::open(const std::string& suffix) {
+    std::ostringstream& buffer = buffers[suffix];
+    buffer.str("");
+    return &buffer;
+}
+
+std::unique_ptr<CodeSink> MemoryArtifactStore::openSink(const std::string& suffix) {
+    std::string& buffer = sinkBuffers[suffix];
+    buffer.clear();
+    return std::make_unique<StringCodeSink>(buffer);
+}
+
+void MemoryArtifactStore::discard(const std::string& suffix) {
+    buffers.erase(suffix);
+    sinkBuffers.erase(suffix);
+}
+
+std::string MemoryArtifactStore::location(const std::string& suffix) const {
+    return dir + "/" + base_name + suffix;
+}
+
+std::map<std::string, std::string> MemoryArtifactStore::release() {
+    std::map<std::string, std::string> result = std::move(sinkBuffers);
+    for (const auto& entry : buffers) {
+        result[entry.first] = entry.second.str();
+    }
+    buffers.clear();
+    sinkBuffers.clear();
+    return result;
+}
@@ -0,0 +1,70 @@
+#ifndef ARTIFACT_STORE_H
+#define ARTIFACT_STORE_H
+
+#include <string>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <fstream>
+#include "code_sink.h"
+
+// Destination for the files a compilation produces (token list, AST dump,
+// semantic log, assembly). Artifacts are named by their suffix, e.g. ".ast.txt".
+class ArtifactStore {
+public:
+    virtual ~ArtifactStore() = default;
+
+    // Returns the stream to write the artifact to, or nullptr if it can't be created.
+    virtual std::ostream* open(const std::string& suffix) = 0;
+    // Flushes and releases the artifact.
+    virtual void close(const std::string& suffix) = 0;
+    // Sink for artifacts written in pieces (the assembly); nullptr on failure.
+    // The artifact is complete once the sink's finish() returns.
+    virtual std::unique_ptr<CodeSink> openSink(const std::string& suffix) = 0;
+    // Drops a partly written artifact.
+    virtual void discard(const std::string& suffix) = 0;
+    // Where the artifact ends up, for progress messages.
+    virtual std::string location(const std::string& suffix) const = 0;
+};
+
+// Writes artifacts as <dir>/<base_name><suffix>; the directory must exist.
+class FileArtifactStore : public ArtifactStore {
+private:
+    std::string dir;
+    std::string base_name;
+    std::map<std::string, std::unique_ptr<std::ofstream>> files;
+
+public:
+    FileArtifactStore(std::string directory, std::string baseName);
+
+    std::ostream* open(const std::string& suffix) override;
+    void close(const std::string& suffix) override;
+    std::unique_ptr<CodeSink> openSink(const std::string& suffix) override;
+    void discard(const std::string& suffix) override;
+    std::string location(const std::string& suffix) const override;
+};
+
+// Keeps artifacts in memory, for the compile server. Nothing touches the disk;
+// location() still reports the path the file-based driver would have used.
+class MemoryArtifactStore : public ArtifactStore {
+private:
+    std::string dir;
+    std::string base_name;
+    std::map<std::string, std::ostringstream> buffers;
+    std::map<std::string, std::string> sinkBuffers;
+
+public:
+    MemoryArtifactStore(std::string directory, std::string baseName);
+
+    std::ostream* open(const std::string& suffix) override;
+    void close(const std::string& suffix) override {}
+    std::unique_ptr<CodeSink> openSink(const std::string& suffix) override;
+    void discard(const std::string& suffix) override;
+    std::string location(const std::string& suffix) const override;
+
+    // Hands over the finished artifacts, keyed by suffix, and empties the store.
+    std::map<std::string, std::string> release();
+};
+
+#endif // ARTIFACT_STORE_H
@@ -1,5 +1,6 @@
 #include "ast.h"
 #include <iostream> // For std::cout, std::endl, etc.
+#include <iterator>
 
 // Helper function for indentation
 static void print_indent(std::ostream& out, int indentLevel) {
@@ -9,58 +10,51 @@ static void print_indent(std::ostream& out, int indentLevel) {
 }
 
 // --- Base Node Class Implementation ---
-Node::Node(int l, int c) : line(l), column(c), father(nullptr) {}
-// Node::print is pure virtual
-// Node::accept is pure virtual
-
-// --- Lexer Helper Original Classes Implementations ---
-Expr::Expr(int l, int c) : Node(l, c) {}
-void Expr::print(std::ostream& out, int indentLevel) const {
-    print_indent(out, indentLevel);
-    out << "Lexer::Expr (L:" << line << ", C:" << column << ") (Should not be in final AST)" << std::endl;
-}
-void Expr::accept(SemanticVisitor& visitor) { /* Stub */ }
-
-Ident::Ident(const std::string& n, int l, int c) : Node(l, c), name(n) {}
-void Ident::print(std::ostream& out, int indentLevel) const {
-    print_indent(out, indentLevel);
-    out << "Lexer::Ident (Name: " << name << ", L:" << line << ", C:" << column << ") (Should not be in final AST)" << std::endl;
-}
-void Ident::accept(SemanticVisitor& visitor) { /* Stub */ }
-
-Num::Num(int val, int l, int c) : Expr(l, c), value(val) {}
-void Num::print(std::ostream& out, int indentLevel) const {
-    print_indent(out, indentLevel);
-    out << "Lexer::Num (Value: " << value << ", L:" << line << ", C:" << column << ") (Should not be in final AST)" << std::endl;
-}
-void Num::accept(SemanticVisitor& visitor) { /* Stub */ }
-
-RealLit::RealLit(double val, int l, int c) : Expr(l, c), value(val) {}
-void RealLit::print(std::ostream& out, int indentLevel) const {
-    print_indent(out, indentLevel);
-    out << "Lexer::RealLit (Value: " << value << ", L:" << line << ", C:" << column << ") (Should not be in final AST)" << std::endl;
+static thread_local size_t nodes_created = 0;
+
+Node::Node(NodeKind k, int l, int c) : nodeKind(k), line(l), column(c), father(nullptr) { nodes_created++; }
+
+size_t Node::createdOnThisThread() { return nodes_created; }
+
+void Node::print(std::ostream& out, int indentLevel) const {
+    // Everything still to print, the next item last.
+    std::vector<PrintQueue::Item> pending;
+    pending.push_back({ this, indentLevel, {} });
+    PrintQueue rest;
+    while (!pending.empty()) {
+        PrintQueue::Item item = std::move(pending.back());
+        pending.pop_back();
+        if (!item.node) {
+            print_indent(out, item.indentLevel);
+            out << item.text << std::endl;
+            continue;
+        }
+        item.node->printSelf(out, item.indentLevel, rest);
+        pending.insert(pending.end(), std::make_move_iterator(rest.items.rbegin()), std::make_move_iterator(rest.items.rend()));
+        rest.items.clear();
+    }
 }
-void RealLit::accept(SemanticVisitor& visitor) { /* Stub */ }
-
+// Node::printSelf is pure virtual
+// Node::accept is pure virtual
 
 // --- BASE AST NODE Implementations ---
-ExprNode::ExprNode(int l, int c) : Node(l, c), determinedType(EntryTypeCategory::UNKNOWN_TYPE) {
+ExprNode::ExprNode(NodeKind k, int l, int c) : Node(k, l, c), determinedType(EntryTypeCategory::UNKNOWN_TYPE) {
     determinedArrayDetails.isInitialized = false; // Initialize array details
 }
-void ExprNode::print(std::ostream& out, int indentLevel) const {
+void ExprNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "ExprNode (Base) (L:" << line << ", C:" << column << ")";
     out << std::endl;
 }
 
-StatementNode::StatementNode(int l, int c) : Node(l, c) {}
-void StatementNode::print(std::ostream& out, int indentLevel) const {
+StatementNode::StatementNode(NodeKind k, int l, int c) : Node(k, l, c) {}
+void StatementNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "StatementNode (Base) (L:" << line << ", C:" << column << ")" << std::endl;
 }
 
-TypeNode::TypeNode(int l, int c) : Node(l, c) {}
-void TypeNode::print(std::ostream& out, int indentLevel) const {
+TypeNode::TypeNode(NodeKind k, int l, int c) : Node(k, l, c) {}
+void TypeNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "TypeNode (Base) (L:" << line << ", C:" << column << ")" << std::endl;
 }
@@ -99,43 +93,44 @@ void ReturnStatementNode::accept(SemanticVisitor& visitor) { visitor.visit(*this
 void ProgramNode::accept(SemanticVisitor& visitor) { visitor.visit(*this); }
 
 // (IdentNode print)
-IdentNode::IdentNode(const std::string& n, int l, int c) : ExprNode(l, c), name(n) {}
-void IdentNode::print(std::ostream& out, int indentLevel) const {
+IdentNode::IdentNode(SymbolId i, const std::string& n, int l, int c) : ExprNode(NodeKind::IDENT, l, c), id(i), name(n) {}
+void IdentNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "IdentNode (Name: " << name << ", L:" << line << ", C:" << column << ")" << std::endl;
 }
 
 // (IntNumNode print)
-IntNumNode::IntNumNode(int val, int l, int c) : ExprNode(l, c), value(val) {}
-void IntNumNode::print(std::ostream& out, int indentLevel) const {
+IntNumNode::IntNumNode(int64_t val, int l, int c) : ExprNode(NodeKind::INT_NUM, l, c), value(val) {}
+void IntNumNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "IntNumNode (Value: " << value << ", L:" << line << ", C:" << column << ")" << std::endl;
 }
 
 // (RealNumNode print)
-RealNumNode::RealNumNode(double val, int l, int c) : ExprNode(l, c), value(val) {}
-void RealNumNode::print(std::ostream& out, int indentLevel) const {
+RealNumNode::RealNumNode(double val, int l, int c) : ExprNode(NodeKind::REAL_NUM, l, c), value(val) {}
+void RealNumNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "RealNumNode (Value: " << value << ", L:" << line << ", C:" << column << ")" << std::endl;
 }
 
 // (BooleanLiteralNode print)
-BooleanLiteralNode::BooleanLiteralNode(bool val, int l, int c) : ExprNode(l, c), value(val) {}
-void BooleanLiteralNode::print(std::ostream& out, int indentLevel) const {
+BooleanLiteralNode::BooleanLiteralNode(bool val, int l, int c) : ExprNode(NodeKind::BOOLEAN_LITERAL, l, c), value(val) {}
+void BooleanLiteralNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "BooleanLiteralNode (Value: " << (value ? "true" : "false") << ", L:" << line << ", C:" << column << ")" << std::endl;
 }
 
 // (StringLiteralNode print)
-StringLiteralNode::StringLiteralNode(const char* val, int l, int c)
-    : ExprNode(l, c), value(val ? val : "") {}
-void StringLiteralNode::print(std::ostream& out, int indentLevel) const {
+StringLiteralNode::StringLiteralNode(std::string_view val, int l, int c)
+    : ExprNode(NodeKind::STRING_LITERAL, l, c), value(val) {}
+void StringLiteralNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "StringLiteralNode (Value: \"" << value << "\", L:" << line << ", C:" << column << ")" << std::endl;
 }
 
 // (IdentifierList print)
-IdentifierList::IdentifierList(IdentNode* firstIdent, int l, int c) : Node(l, c) {
+IdentifierList::IdentifierList(Arena& arena, IdentNode* firstIdent, int l, int c)
+    : Node(NodeKind::IDENTIFIER_LIST, l, c), identifiers(arena) {
     if (firstIdent) {
         identifiers.push_back(firstIdent);
         if (firstIdent) firstIdent->father = this;
@@ -147,18 +142,18 @@ void IdentifierList::addIdentifier(IdentNode* ident) {
         ident->father = this;
     }
 }
-void IdentifierList::print(std::ostream& out, int indentLevel) const {
+void IdentifierList::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "IdentifierList (L:" << line << ", C:" << column << ")" << std::endl;
     for (IdentNode* id : identifiers) {
-        if (id) id->print(out, indentLevel + 1);
+        if (id) rest.child(id, indentLevel + 1);
     }
 }
 
 // (StandardTypeNode print)
 StandardTypeNode::StandardTypeNode(StandardTypeNode::TypeCategory cat, int l, int c)
-    : TypeNode(l, c), category(cat) {}
-void StandardTypeNode::print(std::ostream& out, int indentLevel) const {
+    : TypeNode(NodeKind::STANDARD_TYPE, l, c), category(cat) {}
+void StandardTypeNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "StandardTypeNode (Type: ";
     switch (category) {
@@ -172,37 +167,38 @@ void StandardTypeNode::print(std::ostream& out, int indentLevel) const {
 
 // (ArrayTypeNode print)
 ArrayTypeNode::ArrayTypeNode(IntNumNode* start, IntNumNode* end, StandardTypeNode* elemType, int l, int c)
-    : TypeNode(l, c), startIndex(start), endIndex(end), elementType(elemType) {
+    : TypeNode(NodeKind::ARRAY_TYPE, l, c), startIndex(start), endIndex(end), elementType(elemType) {
     if (startIndex) startIndex->father = this;
     if (endIndex) endIndex->father = this;
     if (elementType) elementType->father = this;
 }
-void ArrayTypeNode::print(std::ostream& out, int indentLevel) const {
+void ArrayTypeNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "ArrayTypeNode (L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "StartIndex:" << std::endl;
-    if (startIndex) startIndex->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "EndIndex:" << std::endl;
-    if (endIndex) endIndex->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "ElementType:" << std::endl;
-    if (elementType) elementType->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
+    rest.text(indentLevel + 1, "StartIndex:");
+    rest.childOr(startIndex, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "EndIndex:");
+    rest.childOr(endIndex, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "ElementType:");
+    rest.childOr(elementType, indentLevel + 2, "nullptr");
 }
 
 // (VarDecl print)
 VarDecl::VarDecl(IdentifierList* ids, TypeNode* t, int l, int c)
-    : StatementNode(l, c), identifiers(ids), type(t) {
+    : StatementNode(NodeKind::VAR_DECL, l, c), identifiers(ids), type(t) {
     if (identifiers) identifiers->father = this;
     if (type) type->father = this;
 }
-void VarDecl::print(std::ostream& out, int indentLevel) const {
+void VarDecl::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "VarDecl (L:" << line << ", C:" << column << ")" << std::endl;
-    if (identifiers) identifiers->print(out, indentLevel + 1); else { print_indent(out, indentLevel + 1); out << "Identifiers: nullptr" << std::endl; }
-    if (type) type->print(out, indentLevel + 1); else { print_indent(out, indentLevel + 1); out << "Type: nullptr" << std::endl; }
+    rest.childOr(identifiers, indentLevel + 1, "Identifiers: nullptr");
+    rest.childOr(type, indentLevel + 1, "Type: nullptr");
 }
 
 // (Declarations print)
-Declarations::Declarations(int l, int c) : Node(l, c) {}
+Declarations::Declarations(Arena& arena, int l, int c)
+    : Node(NodeKind::DECLARATIONS, l, c), var_decl_items(arena) {}
 void Declarations::addVarDecl(VarDecl* vd) {
     if (vd) {
         var_decl_items.push_back(vd);
@@ -212,23 +208,24 @@ void Declarations::addVarDecl(VarDecl* vd) {
 bool Declarations::isEmpty() const {
     return var_decl_items.empty();
 }
-void Declarations::print(std::ostream& out, int indentLevel) const {
+void Declarations::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "Declarations (L:" << line << ", C:" << column << ")" << std::endl;
     if (var_decl_items.empty()) {
-        print_indent(out, indentLevel + 1);
-        out << "(No variable declarations)" << std::endl;
+        rest.text(indentLevel + 1, "(No variable declarations)");
     }
     else {
         for (VarDecl* vd_item : var_decl_items) {
-            if (vd_item) vd_item->print(out, indentLevel + 1);
+            if (vd_item) rest.child(vd_item, indentLevel + 1);
         }
     }
 }
 
 // (ExpressionList print)
-ExpressionList::ExpressionList(int l, int c) : Node(l, c) {}
-ExpressionList::ExpressionList(ExprNode* firstExpr, int l, int c) : Node(l, c) {
+ExpressionList::ExpressionList(Arena& arena, int l, int c)
+    : Node(NodeKind::EXPRESSION_LIST, l, c), expressions(arena) {}
+ExpressionList::ExpressionList(Arena& arena, ExprNode* firstExpr, int l, int c)
+    : Node(NodeKind::EXPRESSION_LIST, l, c), expressions(arena) {
     if (firstExpr) {
         expressions.push_back(firstExpr);
         if (firstExpr) firstExpr->father = this;
@@ -240,35 +237,35 @@ void ExpressionList::addExpression(ExprNode* expr) {
         expr->father = this;
     }
 }
-void ExpressionList::print(std::ostream& out, int indentLevel) const {
+void ExpressionList::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "ExpressionList (L:" << line << ", C:" << column << ")" << std::endl;
     if (expressions.empty()) {
-        print_indent(out, indentLevel + 1);
-        out << "(Empty)" << std::endl;
+        rest.text(indentLevel + 1, "(Empty)");
     }
     else {
         for (ExprNode* expr_node : expressions) {
-            if (expr_node) expr_node->print(out, indentLevel + 1);
+            if (expr_node) rest.child(expr_node, indentLevel + 1);
         }
     }
 }
 
 // (ParameterDeclaration print)
 ParameterDeclaration::ParameterDeclaration(IdentifierList* idList, TypeNode* t, int l, int c)
-    : Node(l, c), ids(idList), type(t) {
+    : Node(NodeKind::PARAMETER_DECLARATION, l, c), ids(idList), type(t) {
     if (ids) ids->father = this;
     if (type) type->father = this;
 }
-void ParameterDeclaration::print(std::ostream& out, int indentLevel) const {
+void ParameterDeclaration::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "ParameterDeclaration (L:" << line << ", C:" << column << ")" << std::endl;
-    if (ids) ids->print(out, indentLevel + 1); else { print_indent(out, indentLevel + 1); out << "Identifiers: nullptr" << std::endl; }
-    if (type) type->print(out, indentLevel + 1); else { print_indent(out, indentLevel + 1); out << "Type: nullptr" << std::endl; }
+    rest.childOr(ids, indentLevel + 1, "Identifiers: nullptr");
+    rest.childOr(type, indentLevel + 1, "Type: nullptr");
 }
 
 // (ParameterList print)
-ParameterList::ParameterList(ParameterDeclaration* firstParamDecl, int l, int c) : Node(l, c) {
+ParameterList::ParameterList(Arena& arena, ParameterDeclaration* firstParamDecl, int l, int c)
+    : Node(NodeKind::PARAMETER_LIST, l, c), paramDeclarations(arena) {
     if (firstParamDecl) {
         paramDeclarations.push_back(firstParamDecl);
         if (firstParamDecl) firstParamDecl->father = this;
@@ -280,83 +277,83 @@ void ParameterList::addParameterDeclarationGroup(ParameterDeclaration* paramDecl
         paramDecl->father = this;
     }
 }
-void ParameterList::print(std::ostream& out, int indentLevel) const {
+void ParameterList::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "ParameterList (L:" << line << ", C:" << column << ")" << std::endl;
     if (paramDeclarations.empty()) {
-        print_indent(out, indentLevel + 1);
-        out << "(No parameters)" << std::endl;
+        rest.text(indentLevel + 1, "(No parameters)");
     }
     else {
         for (ParameterDeclaration* pd_item : paramDeclarations) {
-            if (pd_item) pd_item->print(out, indentLevel + 1);
+            if (pd_item) rest.child(pd_item, indentLevel + 1);
         }
     }
 }
 
 // (ArgumentsNode print)
-ArgumentsNode::ArgumentsNode(int l, int c) : Node(l, c), params(nullptr) {}
-ArgumentsNode::ArgumentsNode(ParameterList* pList, int l, int c) : Node(l, c), params(pList) {
+ArgumentsNode::ArgumentsNode(int l, int c) : Node(NodeKind::ARGUMENTS, l, c), params(nullptr) {}
+ArgumentsNode::ArgumentsNode(ParameterList* pList, int l, int c) : Node(NodeKind::ARGUMENTS, l, c), params(pList) {
     if (params) params->father = this;
 }
-void ArgumentsNode::print(std::ostream& out, int indentLevel) const {
+void ArgumentsNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "ArgumentsNode (L:" << line << ", C:" << column << ")" << std::endl;
     if (params && !params->paramDeclarations.empty()) {
-        params->print(out, indentLevel + 1);
+        rest.child(params, indentLevel + 1);
     }
     else {
-        print_indent(out, indentLevel + 1);
-        out << "(No arguments)" << std::endl;
+        rest.text(indentLevel + 1, "(No arguments)");
     }
 }
 
 // (SubprogramHead print)
-SubprogramHead::SubprogramHead(IdentNode* n, ArgumentsNode* args_in, int l, int c)
-    : Node(l, c), name(n), arguments(args_in) {
+SubprogramHead::SubprogramHead(NodeKind k, IdentNode* n, ArgumentsNode* args_in, int l, int c)
+    : Node(k, l, c), name(n), arguments(args_in) {
     if (name) name->father = this;
     if (arguments) arguments->father = this;
 }
-void SubprogramHead::print(std::ostream& out, int indentLevel) const {
+void SubprogramHead::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "SubprogramHead (Base) (L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "Name:" << std::endl;
-    if (name) name->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "Arguments:" << std::endl;
-    if (arguments) arguments->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
+    rest.text(indentLevel + 1, "Name:");
+    rest.childOr(name, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "Arguments:");
+    rest.childOr(arguments, indentLevel + 2, "nullptr");
 }
 
 // (FunctionHeadNode print)
 FunctionHeadNode::FunctionHeadNode(IdentNode* n, ArgumentsNode* args_in, StandardTypeNode* retType, int l, int c)
-    : SubprogramHead(n, args_in, l, c), returnType(retType) {
+    : SubprogramHead(NodeKind::FUNCTION_HEAD, n, args_in, l, c), returnType(retType) {
     if (returnType) returnType->father = this;
 }
-void FunctionHeadNode::print(std::ostream& out, int indentLevel) const {
+void FunctionHeadNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "FunctionHeadNode (L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "Name:" << std::endl;
-    if (name) name->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "Arguments:" << std::endl;
-    if (arguments) arguments->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "ReturnType:" << std::endl;
-    if (returnType) returnType->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
+    rest.text(indentLevel + 1, "Name:");
+    rest.childOr(name, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "Arguments:");
+    rest.childOr(arguments, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "ReturnType:");
+    rest.childOr(returnType, indentLevel + 2, "nullptr");
 }
 
 // (ProcedureHeadNode print)
 ProcedureHeadNode::ProcedureHeadNode(IdentNode* n, ArgumentsNode* args_in, int l, int c)
-    : SubprogramHead(n, args_in, l, c) {}
-void ProcedureHeadNode::print(std::ostream& out, int indentLevel) const {
+    : SubprogramHead(NodeKind::PROCEDURE_HEAD, n, args_in, l, c) {}
+void ProcedureHeadNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "ProcedureHeadNode (L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "Name:" << std::endl;
-    if (name) name->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "Arguments:" << std::endl;
-    if (arguments) arguments->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
+    rest.text(indentLevel + 1, "Name:");
+    rest.childOr(name, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "Arguments:");
+    rest.childOr(arguments, indentLevel + 2, "nullptr");
 }
 
 // (StatementList print)
-StatementList::StatementList(int l, int c) : Node(l, c) {}
-StatementList::StatementList(StatementNode* firstStmt, int l, int c) : Node(l, c) {
+StatementList::StatementList(Arena& arena, int l, int c)
+    : Node(NodeKind::STATEMENT_LIST, l, c), statements(arena) {}
+StatementList::StatementList(Arena& arena, StatementNode* firstStmt, int l, int c)
+    : Node(NodeKind::STATEMENT_LIST, l, c), statements(arena) {
     if (firstStmt) {
         statements.push_back(firstStmt);
         if (firstStmt) firstStmt->father = this;
@@ -368,267 +365,277 @@ void StatementList::addStatement(StatementNode* stmt) {
         stmt->father = this;
     }
 }
-void StatementList::print(std::ostream& out, int indentLevel) const {
+void StatementList::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "StatementList (L:" << line << ", C:" << column << ")" << std::endl;
     if (statements.empty()) {
-        print_indent(out, indentLevel + 1);
-        out << "(Empty)" << std::endl;
+        rest.text(indentLevel + 1, "(Empty)");
     }
     else {
         for (StatementNode* stmt_item : statements) {
-            if (stmt_item) stmt_item->print(out, indentLevel + 1);
+            if (stmt_item) rest.child(stmt_item, indentLevel + 1);
         }
     }
 }
 
 // (CompoundStatementNode print)
 CompoundStatementNode::CompoundStatementNode(StatementList* sList, int l, int c)
-    : StatementNode(l, c), stmts(sList) {
+    : StatementNode(NodeKind::COMPOUND_STATEMENT, l, c), stmts(sList) {
     if (stmts) stmts->father = this;
 }
-void CompoundStatementNode::print(std::ostream& out, int indentLevel) const {
+void CompoundStatementNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "CompoundStatementNode (L:" << line << ", C:" << column << ")" << std::endl;
-    if (stmts) stmts->print(out, indentLevel + 1); else { print_indent(out, indentLevel + 1); out << "Statements: nullptr" << std::endl; }
+    rest.childOr(stmts, indentLevel + 1, "Statements: nullptr");
 }
 
 // (SubprogramDeclaration print)
 SubprogramDeclaration::SubprogramDeclaration(SubprogramHead* h, Declarations* local_decls, CompoundStatementNode* b, int l, int c)
-    : Node(l, c), head(h), local_declarations(local_decls), body(b) {
+    : Node(NodeKind::SUBPROGRAM_DECLARATION, l, c), head(h), local_declarations(local_decls), body(b) {
     if (head) head->father = this;
     if (local_declarations) local_declarations->father = this;
     if (body) body->father = this;
 }
-void SubprogramDeclaration::print(std::ostream& out, int indentLevel) const {
+void SubprogramDeclaration::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "SubprogramDeclaration (L:" << line << ", C:" << column << ")" << std::endl;
-    if (head) { head->print(out, indentLevel + 1); }
-    else { print_indent(out, indentLevel + 1); out << "Head: nullptr" << std::endl; }
+    if (head) { rest.child(head, indentLevel + 1); }
+    else { rest.text(indentLevel + 1, "Head: nullptr"); }
     if (local_declarations) {
-        print_indent(out, indentLevel + 1); out << "LocalDeclarations:" << std::endl;
-        local_declarations->print(out, indentLevel + 2);
+        rest.text(indentLevel + 1, "LocalDeclarations:");
+        rest.child(local_declarations, indentLevel + 2);
     }
     else {
-        print_indent(out, indentLevel + 1); out << "LocalDeclarations:" << std::endl;
-        print_indent(out, indentLevel + 2); out << "(None or nullptr)" << std::endl;
+        rest.text(indentLevel + 1, "LocalDeclarations:");
+        rest.text(indentLevel + 2, "(None or nullptr)");
     }
-    if (body) { body->print(out, indentLevel + 1); }
-    else { print_indent(out, indentLevel + 1); out << "Body: nullptr" << std::endl; }
+    if (body) { rest.child(body, indentLevel + 1); }
+    else { rest.text(indentLevel + 1, "Body: nullptr"); }
 }
 
 // (SubprogramDeclarations print)
-SubprogramDeclarations::SubprogramDeclarations(int l, int c) : Node(l, c) {}
+SubprogramDeclarations::SubprogramDeclarations(Arena& arena, int l, int c)
+    : Node(NodeKind::SUBPROGRAM_DECLARATIONS, l, c), subprograms(arena) {}
 void SubprogramDeclarations::addSubprogramDeclaration(SubprogramDeclaration* subprog) {
     if (subprog) {
         subprograms.push_back(subprog);
         subprog->father = this;
     }
 }
-void SubprogramDeclarations::print(std::ostream& out, int indentLevel) const {
+void SubprogramDeclarations::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "SubprogramDeclarations (L:" << line << ", C:" << column << ")" << std::endl;
     if (subprograms.empty()) {
-        print_indent(out, indentLevel + 1);
-        out << "(No subprogram declarations)" << std::endl;
+        rest.text(indentLevel + 1, "(No subprogram declarations)");
     }
     else {
         for (SubprogramDeclaration* sub_item : subprograms) {
-            if (sub_item) sub_item->print(out, indentLevel + 1);
+            if (sub_item) rest.child(sub_item, indentLevel + 1);
         }
     }
 }
 
 // (VariableNode print)
 VariableNode::VariableNode(IdentNode* id, ExprNode* idx, int l, int c)
-    : ExprNode(l, c), identifier(id), index(idx),
+    : ExprNode(NodeKind::VARIABLE, l, c), identifier(id), index(idx),
     offset(0), scope(SymbolScope::GLOBAL), kind(SymbolKind::UNKNOWN)
 {
     if (identifier) identifier->father = this;
     if (index) index->father = this;
 }
-void VariableNode::print(std::ostream& out, int indentLevel) const {
+void VariableNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "VariableNode (L:" << line << ", C:" << column << ")" << std::endl;
-    if (identifier) identifier->print(out, indentLevel + 1); else { print_indent(out, indentLevel + 1); out << "Identifier: nullptr" << std::endl; }
+    rest.childOr(identifier, indentLevel + 1, "Identifier: nullptr");
     if (index) {
-        print_indent(out, indentLevel + 1);
-        out << "Index:" << std::endl;
-        index->print(out, indentLevel + 2);
+        rest.text(indentLevel + 1, "Index:");
+        rest.child(index, indentLevel + 2);
     }
 }
 
 // (AssignStatementNode print)
 AssignStatementNode::AssignStatementNode(VariableNode* var, ExprNode* expr, int l, int c)
-    : StatementNode(l, c), variable(var), expression(expr) {
+    : StatementNode(NodeKind::ASSIGN_STATEMENT, l, c), variable(var), expression(expr) {
     if (variable) variable->father = this;
     if (expression) expression->father = this;
 }
-void AssignStatementNode::print(std::ostream& out, int indentLevel) const {
+void AssignStatementNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "AssignStatementNode (L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "Variable:" << std::endl;
-    if (variable) variable->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "Expression:" << std::endl;
-    if (expression) expression->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
+    rest.text(indentLevel + 1, "Variable:");
+    rest.childOr(variable, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "Expression:");
+    rest.childOr(expression, indentLevel + 2, "nullptr");
 }
 
 // (IfStatementNode print)
 IfStatementNode::IfStatementNode(ExprNode* cond, StatementNode* thenStmt, StatementNode* elseStmt, int l, int c)
-    : StatementNode(l, c), condition(cond), thenStatement(thenStmt), elseStatement(elseStmt) {
+    : StatementNode(NodeKind::IF_STATEMENT, l, c), condition(cond), thenStatement(thenStmt), elseStatement(elseStmt) {
     if (condition) condition->father = this;
     if (thenStatement) thenStatement->father = this;
     if (elseStatement) elseStatement->father = this;
 }
-void IfStatementNode::print(std::ostream& out, int indentLevel) const {
+void IfStatementNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "IfStatementNode (L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "Condition:" << std::endl;
-    if (condition) condition->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "ThenStatement:" << std::endl;
-    if (thenStatement) thenStatement->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
+    rest.text(indentLevel + 1, "Condition:");
+    rest.childOr(condition, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "ThenStatement:");
+    rest.childOr(thenStatement, indentLevel + 2, "nullptr");
     if (elseStatement) {
-        print_indent(out, indentLevel + 1); out << "ElseStatement:" << std::endl;
-        elseStatement->print(out, indentLevel + 2);
+        rest.text(indentLevel + 1, "ElseStatement:");
+        rest.child(elseStatement, indentLevel + 2);
     }
     else {
-        print_indent(out, indentLevel + 1); out << "ElseStatement: (none)" << std::endl;
+        rest.text(indentLevel + 1, "ElseStatement: (none)");
     }
 }
 
 // (WhileStatementNode print)
 WhileStatementNode::WhileStatementNode(ExprNode* cond, StatementNode* b, int l, int c)
-    : StatementNode(l, c), condition(cond), body(b) {
+    : StatementNode(NodeKind::WHILE_STATEMENT, l, c), condition(cond), body(b) {
     if (condition) condition->father = this;
     if (body) body->father = this;
 }
-void WhileStatementNode::print(std::ostream& out, int indentLevel) const {
+void WhileStatementNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "WhileStatementNode (L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "Condition:" << std::endl;
-    if (condition) condition->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "Body:" << std::endl;
-    if (body) body->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
+    rest.text(indentLevel + 1, "Condition:");
+    rest.childOr(condition, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "Body:");
+    rest.childOr(body, indentLevel + 2, "nullptr");
 }
 
 // (ProcedureCallStatementNode print)
 ProcedureCallStatementNode::ProcedureCallStatementNode(IdentNode* name_node, ExpressionList* args, int l, int c)
-    : StatementNode(l, c), procName(name_node), arguments(args) {
+    : StatementNode(NodeKind::PROCEDURE_CALL, l, c), procName(name_node), arguments(args) {
     if (procName) procName->father = this;
     if (arguments) arguments->father = this;
 }
-void ProcedureCallStatementNode::print(std::ostream& out, int indentLevel) const {
+void ProcedureCallStatementNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "ProcedureCallStatementNode (L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "Procedure Name:" << std::endl;
-    if (procName) procName->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "Arguments:" << std::endl;
+    rest.text(indentLevel + 1, "Procedure Name:");
+    rest.childOr(procName, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "Arguments:");
     if (arguments && !arguments->expressions.empty()) {
-        arguments->print(out, indentLevel + 2);
+        rest.child(arguments, indentLevel + 2);
     }
     else {
-        print_indent(out, indentLevel + 2); out << "(No arguments or nullptr)" << std::endl;
+        rest.text(indentLevel + 2, "(No arguments or nullptr)");
     }
 }
 
 // (IdExprNode print)
 IdExprNode::IdExprNode(IdentNode* id_node, int l, int c)
-    : ExprNode(l, c), ident(id_node), offset(0), kind(SymbolKind::UNKNOWN), scope(SymbolScope::GLOBAL) { // Initialize new members
+    : ExprNode(NodeKind::ID_EXPR, l, c), ident(id_node), offset(0), kind(SymbolKind::UNKNOWN), scope(SymbolScope::GLOBAL) { // Initialize new members
     if (ident) ident->father = this;
 }
-void IdExprNode::print(std::ostream& out, int indentLevel) const {
+void IdExprNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "IdExprNode (L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "Identifier:" << std::endl;
-    if (ident) ident->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "Kind: " << symbolKindToString(kind) << std::endl;
-    print_indent(out, indentLevel + 1); out << "Scope: " << (scope == SymbolScope::GLOBAL ? "GLOBAL" : "LOCAL") << std::endl;
-    print_indent(out, indentLevel + 1); out << "Offset: " << offset << std::endl;
+    rest.text(indentLevel + 1, "Identifier:");
+    rest.childOr(ident, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "Kind: " + symbolKindToString(kind));
+    rest.text(indentLevel + 1, std::string("Scope: ") + (scope == SymbolScope::GLOBAL ? "GLOBAL" : "LOCAL"));
+    rest.text(indentLevel + 1, "Offset: " + std::to_string(offset));
 }
 
 // (FunctionCallExprNode print)
 FunctionCallExprNode::FunctionCallExprNode(IdentNode* name_node, ExpressionList* args, int l, int c)
-    : ExprNode(l, c), funcName(name_node), arguments(args) {
+    : ExprNode(NodeKind::FUNCTION_CALL, l, c), funcName(name_node), arguments(args) {
     if (funcName) funcName->father = this;
     if (arguments) arguments->father = this;
 }
-void FunctionCallExprNode::print(std::ostream& out, int indentLevel) const {
+void FunctionCallExprNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "FunctionCallExprNode (L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "Function Name:" << std::endl;
-    if (funcName) funcName->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "Arguments:" << std::endl;
+    rest.text(indentLevel + 1, "Function Name:");
+    rest.childOr(funcName, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "Arguments:");
     if (arguments && !arguments->expressions.empty()) {
-        arguments->print(out, indentLevel + 2);
+        rest.child(arguments, indentLevel + 2);
     }
     else {
-        print_indent(out, indentLevel + 2); out << "(No arguments or nullptr)" << std::endl;
+        rest.text(indentLevel + 2, "(No arguments or nullptr)");
     }
 }
 
+// (Operator names)
+const char* binaryOperatorName(BinaryOperator op) {
+    static const char* const names[BINARY_OPERATOR_COUNT] = {
+        "+", "-", "*", "/", "DIV_OP",
+        "AND_OP", "OR_OP",
+        "EQ_OP", "NEQ_OP", "LT_OP", "LTE_OP", "GT_OP", "GTE_OP"
+    };
+    return names[static_cast<size_t>(op)];
+}
+
+const char* unaryOperatorName(UnaryOperator op) {
+    return op == UnaryOperator::NEG ? "-" : "NOT_OP";
+}
+
 // (BinaryOpNode print)
-BinaryOpNode::BinaryOpNode(ExprNode* l_node, const std::string& oper, ExprNode* r_node, int l, int c)
-    : ExprNode(l, c), left(l_node), op(oper), right(r_node) {
+BinaryOpNode::BinaryOpNode(ExprNode* l_node, BinaryOperator oper, ExprNode* r_node, int l, int c)
+    : ExprNode(NodeKind::BINARY_OP, l, c), left(l_node), op(oper), right(r_node) {
     if (left) left->father = this;
     if (right) right->father = this;
 }
-void BinaryOpNode::print(std::ostream& out, int indentLevel) const {
+void BinaryOpNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
-    out << "BinaryOpNode (Operator: " << op << ", L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "LeftOperand:" << std::endl;
-    if (left) left->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "RightOperand:" << std::endl;
-    if (right) right->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
+    out << "BinaryOpNode (Operator: " << binaryOperatorName(op) << ", L:" << line << ", C:" << column << ")" << std::endl;
+    rest.text(indentLevel + 1, "LeftOperand:");
+    rest.childOr(left, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "RightOperand:");
+    rest.childOr(right, indentLevel + 2, "nullptr");
 }
 
 // (UnaryOpNode print)
-UnaryOpNode::UnaryOpNode(const std::string& oper, ExprNode* expr, int l, int c)
-    : ExprNode(l, c), op(oper), expression(expr) {
+UnaryOpNode::UnaryOpNode(UnaryOperator oper, ExprNode* expr, int l, int c)
+    : ExprNode(NodeKind::UNARY_OP, l, c), op(oper), expression(expr) {
     if (expression) expression->father = this;
 }
-void UnaryOpNode::print(std::ostream& out, int indentLevel) const {
+void UnaryOpNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
-    out << "UnaryOpNode (Operator: " << op << ", L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "Expression:" << std::endl;
-    if (expression) expression->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
+    out << "UnaryOpNode (Operator: " << unaryOperatorName(op) << ", L:" << line << ", C:" << column << ")" << std::endl;
+    rest.text(indentLevel + 1, "Expression:");
+    rest.childOr(expression, indentLevel + 2, "nullptr");
 }
 
 // (ReturnStatementNode print)
 ReturnStatementNode::ReturnStatementNode(ExprNode* retVal, int l, int c)
-    : StatementNode(l, c), returnValue(retVal) {
+    : StatementNode(NodeKind::RETURN_STATEMENT, l, c), returnValue(retVal) {
     if (returnValue) returnValue->father = this;
 }
-void ReturnStatementNode::print(std::ostream& out, int indentLevel) const {
+void ReturnStatementNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "ReturnStatementNode (L:" << line << ", C:" << column << ")" << std::endl;
     if (returnValue) {
-        print_indent(out, indentLevel + 1);
-        out << "ReturnValue:" << std::endl;
-        returnValue->print(out, indentLevel + 2);
+        rest.text(indentLevel + 1, "ReturnValue:");
+        rest.child(returnValue, indentLevel + 2);
     }
     else {
-        print_indent(out, indentLevel + 1);
-        out << "ReturnValue: (nullptr or void return - check grammar)" << std::endl;
+        rest.text(indentLevel + 1, "ReturnValue: (nullptr or void return - check grammar)");
     }
 }
 
 // (ProgramNode print)
 ProgramNode::ProgramNode(IdentNode* name_node, Declarations* d, SubprogramDeclarations* s, CompoundStatementNode* cStmt, int l, int c)
-    : Node(l, c), progName(name_node), decls(d), subprogs(s), mainCompoundStmt(cStmt) {
+    : Node(NodeKind::PROGRAM, l, c), progName(name_node), decls(d), subprogs(s), mainCompoundStmt(cStmt) {
     if (progName) progName->father = this;
     if (decls) decls->father = this;
     if (subprogs) subprogs->father = this;
     if (mainCompoundStmt) mainCompoundStmt->father = this;
 }
-void ProgramNode::print(std::ostream& out, int indentLevel) const {
+void ProgramNode::printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const {
     print_indent(out, indentLevel);
     out << "ProgramNode (L:" << line << ", C:" << column << ")" << std::endl;
-    print_indent(out, indentLevel + 1); out << "ProgramName:" << std::endl;
-    if (progName) progName->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "Declarations:" << std::endl;
-    if (decls) decls->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "SubprogramDeclarations:" << std::endl;
-    if (subprogs) subprogs->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
-    print_indent(out, indentLevel + 1); out << "MainCompoundStatement:" << std::endl;
-    if (mainCompoundStmt) mainCompoundStmt->print(out, indentLevel + 2); else { print_indent(out, indentLevel + 2); out << "nullptr" << std::endl; }
+    rest.text(indentLevel + 1, "ProgramName:");
+    rest.childOr(progName, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "Declarations:");
+    rest.childOr(decls, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "SubprogramDeclarations:");
+    rest.childOr(subprogs, indentLevel + 2, "nullptr");
+    rest.text(indentLevel + 1, "MainCompoundStatement:");
+    rest.childOr(mainCompoundStmt, indentLevel + 2, "nullptr");
 }
\ No newline at end of file
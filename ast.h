@@ -4,60 +4,117 @@
 
 #include <vector>
 #include <string>
-#include <list>
+#include <string_view>
 #include <iosfwd>
+#include <cassert>
+#include <cstdint>
 
 #include "semantic_visitor.h"
 #include "semantic_types.h"
+#include "interner.h"
+#include "arena.h"
+#include "small_vector.h"
 
 // Forward-declare SymbolEntry to avoid circular dependencies
 // This allows us to use SymbolEntry* pointers in the AST nodes.
 class SymbolEntry;
 
+// One tag per concrete node class, set at construction. Each class's classof()
+// tests it, which is all isa/cast/dyn_cast below need, so telling nodes apart
+// never goes through RTTI. Subclasses of one base are kept contiguous so the
+// base can test a range.
+enum class NodeKind : unsigned char {
+    // ExprNode
+    IDENT, INT_NUM, REAL_NUM, BOOLEAN_LITERAL, STRING_LITERAL,
+    VARIABLE, ID_EXPR, FUNCTION_CALL, BINARY_OP, UNARY_OP,
+    // StatementNode
+    VAR_DECL, COMPOUND_STATEMENT, ASSIGN_STATEMENT, IF_STATEMENT,
+    WHILE_STATEMENT, PROCEDURE_CALL, RETURN_STATEMENT,
+    // TypeNode
+    STANDARD_TYPE, ARRAY_TYPE,
+    // SubprogramHead
+    FUNCTION_HEAD, PROCEDURE_HEAD,
+    // Direct Node subclasses
+    IDENTIFIER_LIST, DECLARATIONS, EXPRESSION_LIST, PARAMETER_DECLARATION,
+    PARAMETER_LIST, ARGUMENTS, STATEMENT_LIST, SUBPROGRAM_DECLARATION,
+    SUBPROGRAM_DECLARATIONS, PROGRAM
+};
+
+class Node;
+
+// What Node::printSelf() leaves for later. Node::print() keeps these on an
+// explicit stack instead of recursing into the children.
+class PrintQueue {
+public:
+    void child(const Node* node, int indentLevel) { items.push_back({ node, indentLevel, {} }); }
+    void text(int indentLevel, std::string line) { items.push_back({ nullptr, indentLevel, std::move(line) }); }
+    // 'node', or the line 'missing' in its place if there is none
+    void childOr(const Node* node, int indentLevel, const char* missing) {
+        if (node) child(node, indentLevel);
+        else text(indentLevel, missing);
+    }
+
+private:
+    friend class Node;
+    struct Item {
+        const Node* node; // nullptr: a line of text
+        int indentLevel;
+        std::string text;
+    };
+    std::vector<Item> items;
+};
+
 // --- Base Node Class ---
+// Nodes are only ever created in a compilation's Arena, as 'new (arena) X(...)',
+// and are never deleted one by one: the tree goes away with the arena. Their
+// destructors therefore never run, and no node may own heap memory.
 class Node {
+private:
+    NodeKind nodeKind;
+
 public:
     int line;
     int column;
     Node* father;
-    Node(int l, int c);
+    Node(NodeKind k, int l, int c);
+    NodeKind getKind() const { return nodeKind; }
     virtual ~Node() {}
-    virtual void print(std::ostream& out, int indentLevel = 0) const = 0;
-    virtual void accept(SemanticVisitor& visitor) = 0;
-};
 
-// --- Lexer Helper Original Classes ---
-class Expr : public Node {
-public:
-    Expr(int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
-    void accept(SemanticVisitor& visitor) override;
+    static void* operator new(size_t size, Arena& arena) { return arena.allocate(size, alignof(Node)); }
+    static void operator delete(void*, Arena&) {}
+    static void operator delete(void*) {}
+    // Nodes constructed on the calling thread so far, for --time-report
+    static size_t createdOnThisThread();
+    // Prints the subtree, one node per line; deep trees don't recurse.
+    void print(std::ostream& out, int indentLevel = 0) const;
+    // Prints this node's own first line and queues the rest: its children's
+    // subtrees and the labels around them, in output order.
+    virtual void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const = 0;
+    virtual void accept(SemanticVisitor& visitor) = 0;
 };
 
-class Ident : public Node {
-public:
-    std::string name;
-    Ident(const std::string& n, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
-    void accept(SemanticVisitor& visitor) override;
-};
+// isa<T>(node): is 'node' a T? False for nullptr.
+template <typename To>
+bool isa(const Node* node) { return node && To::classof(node); }
 
-class Num : public Expr {
-public:
-    int value;
-    Num(int val, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
-    void accept(SemanticVisitor& visitor) override;
-};
+// cast<T>(node): 'node' as a T; it must be one.
+template <typename To>
+To* cast(Node* node) {
+    assert(isa<To>(node));
+    return static_cast<To*>(node);
+}
 
-class RealLit : public Expr {
-public:
-    double value;
-    RealLit(double val, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
-    void accept(SemanticVisitor& visitor) override;
-};
+template <typename To>
+const To* cast(const Node* node) {
+    assert(isa<To>(node));
+    return static_cast<const To*>(node);
+}
 
+// dyn_cast<T>(node): 'node' as a T, or nullptr if it isn't one (or is nullptr).
+template <typename To>
+To* dyn_cast(Node* node) { return isa<To>(node) ? static_cast<To*>(node) : nullptr; }
+template <typename To>
+const To* dyn_cast(const Node* node) { return isa<To>(node) ? static_cast<const To*>(node) : nullptr; }
 
 // --- BASE AST NODE CLASSES ---
 class ExprNode : public Node {
@@ -66,36 +123,42 @@ public:
     EntryTypeCategory determinedType;
     ArrayDetails determinedArrayDetails; // Valid if determinedType is ARRAY
 
-    ExprNode(int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    ExprNode(NodeKind k, int l, int c);
+    static bool classof(const Node* node) { return node->getKind() >= NodeKind::IDENT && node->getKind() <= NodeKind::UNARY_OP; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
 };
 
 class StatementNode : public Node {
 public:
-    StatementNode(int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    StatementNode(NodeKind k, int l, int c);
+    static bool classof(const Node* node) { return node->getKind() >= NodeKind::VAR_DECL && node->getKind() <= NodeKind::RETURN_STATEMENT; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
 };
 
 class TypeNode : public Node {
 public:
-    TypeNode(int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    TypeNode(NodeKind k, int l, int c);
+    static bool classof(const Node* node) { return node->getKind() >= NodeKind::STANDARD_TYPE && node->getKind() <= NodeKind::ARRAY_TYPE; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
 };
 
 // --- SPECIFIC AST NODE DECLARATIONS ---
 class IdentNode : public ExprNode {
 public:
-    std::string name;
-    IdentNode(const std::string& n, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    SymbolId id;
+    const std::string& name; // owned by the compilation's StringInterner
+    IdentNode(SymbolId i, const std::string& n, int l, int c);
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::IDENT; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
 class IntNumNode : public ExprNode {
 public:
-    int value;
-    IntNumNode(int val, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    int64_t value; // as written; SemanticAnalyzer checks that it fits an integer
+    IntNumNode(int64_t val, int l, int c);
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::INT_NUM; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -103,7 +166,8 @@ class RealNumNode : public ExprNode {
 public:
     double value;
     RealNumNode(double val, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::REAL_NUM; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -111,24 +175,27 @@ class BooleanLiteralNode : public ExprNode {
 public:
     bool value;
     BooleanLiteralNode(bool val, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::BOOLEAN_LITERAL; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
 class StringLiteralNode : public ExprNode {
 public:
-    std::string value;
-    StringLiteralNode(const char* val, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    std::string_view value; // arena copy
+    StringLiteralNode(std::string_view val, int l, int c);
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::STRING_LITERAL; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
 class IdentifierList : public Node {
 public:
-    std::list<IdentNode*> identifiers;
-    IdentifierList(IdentNode* firstIdent, int l, int c);
+    SmallVector<IdentNode*, 4> identifiers;
+    IdentifierList(Arena& arena, IdentNode* firstIdent, int l, int c);
     void addIdentifier(IdentNode* ident);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::IDENTIFIER_LIST; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -137,7 +204,8 @@ public:
     enum TypeCategory { TYPE_INTEGER, TYPE_REAL, TYPE_BOOLEAN };
     TypeCategory category;
     StandardTypeNode(TypeCategory cat, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::STANDARD_TYPE; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -147,7 +215,8 @@ public:
     IntNumNode* endIndex;
     StandardTypeNode* elementType;
     ArrayTypeNode(IntNumNode* start, IntNumNode* end, StandardTypeNode* elemType, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::ARRAY_TYPE; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -156,27 +225,30 @@ public:
     IdentifierList* identifiers;
     TypeNode* type;
     VarDecl(IdentifierList* ids, TypeNode* t, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::VAR_DECL; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
 class Declarations : public Node {
 public:
-    std::list<VarDecl*> var_decl_items;
-    Declarations(int l, int c);
+    SmallVector<VarDecl*, 4> var_decl_items;
+    Declarations(Arena& arena, int l, int c);
     void addVarDecl(VarDecl* vd);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::DECLARATIONS; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     bool isEmpty() const;
     void accept(SemanticVisitor& visitor) override;
 };
 
 class ExpressionList : public Node {
 public:
-    std::list<ExprNode*> expressions;
-    ExpressionList(int l, int c);
-    ExpressionList(ExprNode* firstExpr, int l, int c);
+    SmallVector<ExprNode*, 4> expressions;
+    ExpressionList(Arena& arena, int l, int c);
+    ExpressionList(Arena& arena, ExprNode* firstExpr, int l, int c);
     void addExpression(ExprNode* expr);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::EXPRESSION_LIST; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -185,16 +257,18 @@ public:
     IdentifierList* ids;
     TypeNode* type;
     ParameterDeclaration(IdentifierList* idList, TypeNode* t, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::PARAMETER_DECLARATION; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
 class ParameterList : public Node {
 public:
-    std::list<ParameterDeclaration*> paramDeclarations;
-    ParameterList(ParameterDeclaration* firstParamDecl, int l, int c);
+    SmallVector<ParameterDeclaration*, 4> paramDeclarations;
+    ParameterList(Arena& arena, ParameterDeclaration* firstParamDecl, int l, int c);
     void addParameterDeclarationGroup(ParameterDeclaration* paramDecl);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::PARAMETER_LIST; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -203,7 +277,8 @@ public:
     ParameterList* params;
     ArgumentsNode(int l, int c);
     ArgumentsNode(ParameterList* pList, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::ARGUMENTS; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -211,33 +286,37 @@ class SubprogramHead : public Node {
 public:
     IdentNode* name;
     ArgumentsNode* arguments;
-    SubprogramHead(IdentNode* n, ArgumentsNode* args, int l, int c);
+    SubprogramHead(NodeKind k, IdentNode* n, ArgumentsNode* args, int l, int c);
     virtual ~SubprogramHead() {}
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() >= NodeKind::FUNCTION_HEAD && node->getKind() <= NodeKind::PROCEDURE_HEAD; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
 };
 
 class FunctionHeadNode : public SubprogramHead {
 public:
     StandardTypeNode* returnType;
     FunctionHeadNode(IdentNode* n, ArgumentsNode* args, StandardTypeNode* retType, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::FUNCTION_HEAD; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
 class ProcedureHeadNode : public SubprogramHead {
 public:
     ProcedureHeadNode(IdentNode* n, ArgumentsNode* args, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::PROCEDURE_HEAD; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
 class StatementList : public Node {
 public:
-    std::list<StatementNode*> statements;
-    StatementList(int l, int c);
-    StatementList(StatementNode* firstStmt, int l, int c);
+    SmallVector<StatementNode*, 4> statements;
+    StatementList(Arena& arena, int l, int c);
+    StatementList(Arena& arena, StatementNode* firstStmt, int l, int c);
     void addStatement(StatementNode* stmt);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::STATEMENT_LIST; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -245,7 +324,8 @@ class CompoundStatementNode : public StatementNode {
 public:
     StatementList* stmts;
     CompoundStatementNode(StatementList* sList, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::COMPOUND_STATEMENT; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -255,16 +335,18 @@ public:
     Declarations* local_declarations;
     CompoundStatementNode* body;
     SubprogramDeclaration(SubprogramHead* h, Declarations* local_decls, CompoundStatementNode* b, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::SUBPROGRAM_DECLARATION; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
 class SubprogramDeclarations : public Node {
 public:
-    std::list<SubprogramDeclaration*> subprograms;
-    SubprogramDeclarations(int l, int c);
+    SmallVector<SubprogramDeclaration*, 4> subprograms;
+    SubprogramDeclarations(Arena& arena, int l, int c);
     void addSubprogramDeclaration(SubprogramDeclaration* subprog);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::SUBPROGRAM_DECLARATIONS; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -277,7 +359,8 @@ public:
     SymbolKind kind;
     SymbolScope scope;
     VariableNode(IdentNode* id, ExprNode* idx, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::VARIABLE; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -286,7 +369,8 @@ public:
     VariableNode* variable;
     ExprNode* expression;
     AssignStatementNode(VariableNode* var, ExprNode* expr, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::ASSIGN_STATEMENT; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -296,7 +380,8 @@ public:
     StatementNode* thenStatement;
     StatementNode* elseStatement;
     IfStatementNode(ExprNode* cond, StatementNode* thenStmt, StatementNode* elseStmt, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::IF_STATEMENT; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -305,7 +390,8 @@ public:
     ExprNode* condition;
     StatementNode* body;
     WhileStatementNode(ExprNode* cond, StatementNode* b, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::WHILE_STATEMENT; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -316,7 +402,8 @@ public:
     // ADDED: A pointer to the specific procedure overload resolved by the semantic analyzer.
     SymbolEntry* resolved_entry = nullptr;
     ProcedureCallStatementNode(IdentNode* name, ExpressionList* args, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::PROCEDURE_CALL; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -327,7 +414,8 @@ public:
     SymbolKind kind;
     SymbolScope scope;
     IdExprNode(IdentNode* id, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::ID_EXPR; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -338,26 +426,44 @@ public:
     // ADDED: A pointer to the specific function overload resolved by the semantic analyzer.
     SymbolEntry* resolved_entry = nullptr;
     FunctionCallExprNode(IdentNode* name, ExpressionList* args, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::FUNCTION_CALL; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
+// Operators as the parser sets them. The analyzers key their type-rule and
+// opcode tables by these, so keep those tables in this order.
+enum class BinaryOperator : unsigned char {
+    ADD, SUB, MUL, REAL_DIV, INT_DIV,
+    AND, OR,
+    EQ, NEQ, LT, LTE, GT, GTE
+};
+const size_t BINARY_OPERATOR_COUNT = static_cast<size_t>(BinaryOperator::GTE) + 1;
+
+enum class UnaryOperator : unsigned char { NEG, NOT };
+
+// Spelling used by the AST dump and diagnostics ("+", "DIV_OP", "LTE_OP", ...)
+const char* binaryOperatorName(BinaryOperator op);
+const char* unaryOperatorName(UnaryOperator op);
+
 class BinaryOpNode : public ExprNode {
 public:
     ExprNode* left;
-    std::string op;
+    BinaryOperator op;
     ExprNode* right;
-    BinaryOpNode(ExprNode* l_node, const std::string& oper, ExprNode* r_node, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    BinaryOpNode(ExprNode* l_node, BinaryOperator oper, ExprNode* r_node, int l, int c);
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::BINARY_OP; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
 class UnaryOpNode : public ExprNode {
 public:
-    std::string op;
+    UnaryOperator op;
     ExprNode* expression;
-    UnaryOpNode(const std::string& oper, ExprNode* expr, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    UnaryOpNode(UnaryOperator oper, ExprNode* expr, int l, int c);
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::UNARY_OP; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -365,7 +471,8 @@ class ReturnStatementNode : public StatementNode {
 public:
     ExprNode* returnValue;
     ReturnStatementNode(ExprNode* retVal, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::RETURN_STATEMENT; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
@@ -376,7 +483,8 @@ public:
     SubprogramDeclarations* subprogs;
     CompoundStatementNode* mainCompoundStmt;
     ProgramNode(IdentNode* name, Declarations* d, SubprogramDeclarations* s, CompoundStatementNode* cStmt, int l, int c);
-    void print(std::ostream& out, int indentLevel = 0) const override;
+    static bool classof(const Node* node) { return node->getKind() == NodeKind::PROGRAM; }
+    void printSelf(std::ostream& out, int indentLevel, PrintQueue& rest) const override;
     void accept(SemanticVisitor& visitor) override;
 };
 
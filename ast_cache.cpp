@@ -0,0 +1,161 @@
+#include "ast_cache.h"
+
+// Bump whenever the entry layout, FlatAst or the node kinds change.
+static const uint32_t FORMAT_VERSION = 3;
+static const char* const EXTENSION = ".ast";
+
+// --- Encoding ---
+
+namespace {
+
+void putArrayDetails(CacheWriter& out, const ArrayDetails& details) {
+    out.put(static_cast<uint8_t>(details.elementType));
+    out.put(static_cast<int32_t>(details.lowBound));
+    out.put(static_cast<int32_t>(details.highBound));
+    out.put(static_cast<uint8_t>(details.isInitialized));
+}
+
+void putSymbol(CacheWriter& out, const SymbolEntry& entry) {
+    out.putString(entry.name);
+    out.put(static_cast<uint8_t>(entry.kind));
+    out.put(static_cast<uint8_t>(entry.type));
+    out.put(static_cast<int32_t>(entry.offset));
+    putArrayDetails(out, entry.arrayDetails);
+    out.put(static_cast<uint8_t>(entry.functionReturnType));
+    out.put(static_cast<uint32_t>(entry.formalParameterSignature.size()));
+    for (const auto& parameter : entry.formalParameterSignature) {
+        out.put(static_cast<uint8_t>(parameter.first));
+        putArrayDetails(out, parameter.second);
+    }
+    out.put(static_cast<uint32_t>(entry.numParameters));
+    out.put(static_cast<int32_t>(entry.declLine));
+    out.put(static_cast<int32_t>(entry.declColumn));
+}
+
+bool getArrayDetails(CacheReader& in, ArrayDetails& details) {
+    int32_t low, high;
+    uint8_t initialized;
+    if (!in.getEnum(details.elementType, EntryTypeCategory::ARRAY) || !in.get(low) || !in.get(high) || !in.get(initialized)) return false;
+    details.lowBound = low;
+    details.highBound = high;
+    details.isInitialized = initialized != 0;
+    return true;
+}
+
+bool getSymbol(CacheReader& in, SymbolEntry& entry) {
+    std::string_view name;
+    int32_t offset, line, column;
+    uint32_t signatureSize, numParameters;
+    if (!in.getString(name) || !in.getEnum(entry.kind, SymbolKind::PROGRAM_NAME) ||
+        !in.getEnum(entry.type, EntryTypeCategory::ARRAY) || !in.get(offset) || !getArrayDetails(in, entry.arrayDetails) ||
+        !in.getEnum(entry.functionReturnType, EntryTypeCategory::ARRAY) || !in.get(signatureSize)) {
+        return false;
+    }
+    entry.name = std::string(name);
+    entry.offset = offset;
+    entry.formalParameterSignature.clear();
+    for (uint32_t i = 0; i < signatureSize; i++) {
+        std::pair<EntryTypeCategory, ArrayDetails> parameter;
+        if (!in.getEnum(parameter.first, EntryTypeCategory::ARRAY) || !getArrayDetails(in, parameter.second)) return false;
+        entry.formalParameterSignature.push_back(parameter);
+    }
+    if (!in.get(numParameters) || !in.get(line) || !in.get(column)) return false;
+    entry.numParameters = numParameters;
+    entry.declLine = line;
+    entry.declColumn = column;
+    return true;
+}
+
+} // namespace
+
+// --- AstCache ---
+
+AstCache::AstCache(CacheDirectory& dir, std::string_view source)
+    : directory(dir), key(CacheKeyBuilder().add(compilerBuildId()).add(source).finish()), sourceLength(source.size()) {}
+
+bool AstCache::load(StringInterner& names, CachedAnalysis& out) const {
+    CacheEntry entry;
+    bool found = directory.fetch(key, EXTENSION, entry);
+    directory.count(found ? CacheDirectory::AST_HIT : CacheDirectory::AST_MISS);
+    if (!found) return false;
+
+    CacheReader in(entry.body());
+    uint32_t version, nameCount;
+    uint64_t length;
+    if (!in.get(version) || version != FORMAT_VERSION || !in.get(length) || length != sourceLength ||
+        !in.get(nameCount) || nameCount > in.remaining() / sizeof(uint32_t)) {
+        return false;
+    }
+    std::vector<std::string_view> spellings(nameCount);
+    for (std::string_view& spelling : spellings) {
+        if (!in.getString(spelling)) return false;
+    }
+
+    uint32_t symbolCount;
+    // Counts are checked against what is left before anything is allocated
+    if (!in.get(symbolCount) || symbolCount > in.remaining()) return false;
+    out.globals.assign(symbolCount, SymbolEntry());
+    for (SymbolEntry& global : out.globals) {
+        if (!getSymbol(in, global)) return false;
+    }
+
+    uint32_t nodeCount, childCount, stringBytes;
+    FlatAst& ast = out.ast;
+    const char* strings;
+    if (!in.get(nodeCount) || !in.get(childCount) || !in.get(stringBytes) ||
+        !in.getArray(nodeCount, ast.kinds) || !in.getArray(nodeCount, ast.lines) ||
+        !in.getArray(nodeCount, ast.columns) || !in.getArray(nodeCount, ast.payloads) ||
+        !in.getArray(nodeCount + 1ull, ast.childStart) || !in.getArray(nodeCount, ast.types) ||
+        !in.getArray(nodeCount, ast.offsets) || !in.getArray(childCount, ast.children) ||
+        !in.getBytes(stringBytes, strings) || !in.atEnd()) {
+        return false;
+    }
+    ast.strings.assign(strings, stringBytes);
+    // A checksum only catches damage: a mismatched writer could still have
+    // stored arrays that don't make a tree.
+    if (!ast.validate(spellings.size())) return false;
+
+    // Same names under the same ids; the built-ins come first in both.
+    if (names.size() > spellings.size()) return false;
+    for (size_t id = 0; id < names.size(); id++) {
+        if (names.name(static_cast<SymbolId>(id)) != spellings[id]) return false;
+    }
+    for (size_t id = 0; id < spellings.size(); id++) {
+        if (names.intern(spellings[id]) != id) return false;
+    }
+    return true;
+}
+
+bool AstCache::store(const StringInterner& names, const ProgramNode& root, const SymbolTable& symbols) const {
+    std::unique_ptr<PendingEntry> entry = directory.begin(key, EXTENSION);
+    if (!entry) return false;
+    CacheWriter& out = entry->out();
+    out.put(FORMAT_VERSION);
+    out.put(sourceLength);
+    out.put(static_cast<uint32_t>(names.size()));
+    for (size_t id = 0; id < names.size(); id++) {
+        out.putString(names.name(static_cast<SymbolId>(id)));
+    }
+
+    std::vector<const SymbolEntry*> globals = symbols.globalSymbols();
+    out.put(static_cast<uint32_t>(globals.size()));
+    for (const SymbolEntry* entry : globals) {
+        putSymbol(out, *entry);
+    }
+
+    FlatAst ast = FlatAst::fromTree(root);
+    out.put(static_cast<uint32_t>(ast.size()));
+    out.put(static_cast<uint32_t>(ast.children.size()));
+    out.put(static_cast<uint32_t>(ast.strings.size()));
+    out.putArray(ast.kinds);
+    out.putArray(ast.lines);
+    out.putArray(ast.columns);
+    out.putArray(ast.payloads);
+    out.putArray(ast.childStart);
+    out.putArray(ast.types);
+    out.putArray(ast.offsets);
+    out.putArray(ast.children);
+    out.write(ast.strings.data(), ast.strings.size());
+
+    return directory.commit(std::move(entry));
+}
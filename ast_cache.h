@@ -0,0 +1,45 @@
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include "flat_ast.h"
+#include "cache_directory.h"
+#include "symbol_table.h"
+#include "interner.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// What a cache file gives back: the analyzed tree in flat form and the global
+// scope the analyzer left behind, which is all the code generator looks at.
+struct CachedAnalysis {
+    FlatAst ast;
+    std::vector<SymbolEntry> globals;
+};
+
+// Analyzed programs in a CacheDirectory (--cache-dir). A program that lexed,
+// parsed and analyzed cleanly is stored under the hash of its source text as
+// one <key>.ast entry: the interned names in id order, the global symbols and
+// the FlatAst arrays. Compiling the same text again maps that entry and goes
+// straight to code generation, whatever else about the compilation changed.
+// An entry in another format version or for other text is simply a miss.
+class AstCache {
+private:
+    CacheDirectory& directory;
+    CacheKey key;
+    uint64_t sourceLength;
+
+public:
+    // Cache entry for 'source'
+    AstCache(CacheDirectory& dir, std::string_view source);
+
+    // Reads the entry into 'out' and re-interns its names into 'names', which
+    // must not hold more than the built-in names yet, so every SymbolId in the
+    // entry means the same name again. False on a miss; 'names' is only
+    // touched once the whole file has checked out.
+    bool load(StringInterner& names, CachedAnalysis& out) const;
+
+    // Stores 'root', as analyzed against 'symbols'; false if that failed.
+    bool store(const StringInterner& names, const ProgramNode& root, const SymbolTable& symbols) const;
+};
+
+#endif // AST_CACHE_H
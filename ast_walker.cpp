@@ -0,0 +1,21 @@
+#include "ast_walker.h"
+
+void AstWalker::walk(Node* root) {
+    if (!root) return;
+    size_t base = stack.size();
+    stack.push_back(Frame{ root, 0, 0 });
+    try {
+        while (stack.size() > base) {
+            // resume() gets a copy: a nested walk may reallocate the stack.
+            Frame frame = stack.back();
+            Node* child = resume(frame);
+            stack.back() = frame;
+            if (child) stack.push_back(Frame{ child, 0, 0 });
+            else stack.pop_back();
+        }
+    }
+    catch (...) {
+        stack.resize(base);
+        throw;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef AST_WALKER_H
+#define AST_WALKER_H
+
+#include "ast.h"
+#include <vector>
+
+// Depth-first traversal with an explicit stack instead of recursion, for the
+// passes over statements and expressions, which the parser lets nest as deep
+// as the source does. Each node is handled by resume(), a step function: it
+// does the node's work up to the next child it needs visited, records in
+// frame.step where to carry on and returns that child. When the child's
+// subtree is done, resume() is called again with the same frame. Returning
+// nullptr finishes the node. A deep tree then costs a Frame of heap per
+// level, not a native stack frame per visit call.
+class AstWalker {
+protected:
+    struct Frame {
+        Node* node;
+        unsigned step;  // resume point, 0 on the first call
+        int scratch;    // whatever else the node must keep across its children
+    };
+
+    virtual ~AstWalker() = default;
+
+    // The next child of 'frame.node' to visit, or nullptr once it is done.
+    virtual Node* resume(Frame& frame) = 0;
+
+    // Walks the subtree under 'root'. resume() may start a nested walk, say
+    // by calling accept() on a node of another kind.
+    void walk(Node* root);
+
+    // List elements one per resume() call, counting in frame.scratch and
+    // skipping null entries; nullptr after the last.
+    template <typename List>
+    static Node* nextElement(const List& elements, Frame& frame) {
+        while (static_cast<size_t>(frame.scratch) < elements.size()) {
+            Node* element = elements[frame.scratch++];
+            if (element) return element;
+        }
+        return nullptr;
+    }
+
+private:
+    std::vector<Frame> stack;
+};
+
+#endif // AST_WALKER_H
@@ -0,0 +1,396 @@
+// Throughput benchmark for the compiler phases (make bench).
+//
+// Generates large synthetic MiniPascal programs, compiles each one several
+// times through minipascal::compile() with phase timing on, and reports per
+// phase the best wall time, source bytes per second, what the phase produced
+// per second (tokens, AST nodes, symbols, instructions) and how much the
+// process's peak RSS grew. Peak RSS only grows once per process, so for
+// per-workload memory figures run one workload per process, as `make bench`
+// does.
+//
+// With --save-baseline=FILE the figures are appended to FILE; with
+// --baseline=FILE they are compared against it, and a phase that got more
+// than --tolerance percent slower, or a peak RSS that grew by more than that,
+// fails the run.
+#include "minipascal.h"
+#include "time_report.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// --- Program generator ---
+
+// Thousands of small functions and procedures, all called from the main
+// program. They only work on their parameters: the code generator doesn't
+// allocate subprogram locals yet.
+static std::string generateSubprograms(unsigned scale) {
+    unsigned count = 2000 * scale;
+    std::ostringstream out;
+    out << "PROGRAM BenchSubprograms;\nVAR\n  g: INTEGER;\n  r: REAL;\n\n";
+    for (unsigned i = 0; i < count; i++) {
+        if (i % 2 == 0) {
+            out << "FUNCTION f" << i << "(a: INTEGER; b: REAL): INTEGER;\n"
+                << "  BEGIN\n"
+                << "    a := a * 2 + " << i << ";\n"
+                << "    b := b / 3.5;\n"
+                << "    IF a > 10 THEN a := a - 1 ELSE a := a + 1;\n"
+                << "    WHILE a > 100 DO a := a - 3;\n"
+                << "    RETURN a\n"
+                << "  END;\n\n";
+        }
+        else {
+            out << "PROCEDURE p" << i << "(x: INTEGER; y: REAL);\n"
+                << "  BEGIN\n"
+                << "    IF x <> " << i << " THEN writeln(x) ELSE writeln(y)\n"
+                << "  END;\n\n";
+        }
+    }
+    out << "BEGIN\n  g := 1;\n  r := 1.5";
+    for (unsigned i = 0; i < count; i++) {
+        if (i % 2 == 0) out << ";\n  g := f" << i << "(g, r)";
+        else out << ";\n  p" << i << "(g, r)";
+    }
+    out << "\nEND.\n";
+    return out.str();
+}
+
+// Nested parenthesized integer expression 'depth' levels deep.
+static void nestedExpression(std::ostringstream& out, unsigned depth, unsigned seed) {
+    static const char* const OPERATORS[] = { " + ", " - ", " * ", " DIV " };
+    if (depth == 0) {
+        out << 'v' << seed % 8;
+        return;
+    }
+    // Alternate left- and right-nested operands, so both sides of the
+    // grammar's operator rules see deep subtrees.
+    out << '(';
+    if (depth % 2 == 0) {
+        nestedExpression(out, depth - 1, seed * 7 + 1);
+        out << OPERATORS[depth % 4] << (seed % 97 + 1);
+    }
+    else {
+        out << 'v' << (seed + depth) % 8 << OPERATORS[depth % 4];
+        nestedExpression(out, depth - 1, seed * 5 + 3);
+    }
+    out << ')';
+}
+
+// Assignments of deeply nested arithmetic.
+static std::string generateExpressions(unsigned scale) {
+    unsigned count = 500 * scale;
+    std::ostringstream out;
+    out << "PROGRAM BenchExpressions;\nVAR\n  v0, v1, v2, v3, v4, v5, v6, v7: INTEGER;\n\nBEGIN\n  v0 := 1";
+    for (unsigned i = 0; i < count; i++) {
+        out << ";\n  v" << i % 8 << " := ";
+        nestedExpression(out, 64, i);
+    }
+    out << "\nEND.\n";
+    return out.str();
+}
+
+// One huge VAR section, mostly scalars with an array now and then.
+static std::string generateDeclarations(unsigned scale) {
+    unsigned lines = 2500 * scale;
+    std::ostringstream out;
+    out << "PROGRAM BenchDeclarations;\nVAR\n";
+    for (unsigned i = 0; i < lines; i++) {
+        if (i % 16 == 15) {
+            out << "  a" << i << ": ARRAY [1..100] OF REAL;\n";
+            continue;
+        }
+        out << ' ';
+        for (unsigned j = 0; j < 8; j++) out << (j ? ", " : " ") << 'v' << i << '_' << j;
+        out << (i % 3 == 0 ? ": REAL;\n" : ": INTEGER;\n");
+    }
+    out << "\nBEGIN\n  v1_0 := 1";
+    for (unsigned i = 1; i < lines; i += 97) {
+        if (i % 16 == 15 || i % 3 == 0) continue;
+        out << ";\n  v" << i << "_7 := v" << i << "_0 + 1";
+    }
+    out << "\nEND.\n";
+    return out.str();
+}
+
+// Output statements with long string literals.
+static std::string generateStrings(unsigned scale) {
+    unsigned count = 500 * scale;
+    static const char FILLER[] = "The quick brown fox jumps over the lazy dog 0123456789. ";
+    std::ostringstream out;
+    out << "PROGRAM BenchStrings;\nVAR\n  n: INTEGER;\n\nBEGIN\n  n := 0";
+    for (unsigned i = 0; i < count; i++) {
+        std::string text;
+        size_t length = 1000 + (i * 37) % 3000;
+        while (text.size() < length) text += FILLER;
+        text.resize(length);
+        if (i % 2 == 0) out << ";\n  writeln('" << text << "')";
+        else out << ";\n  write('" << text << "', n)";
+    }
+    out << "\nEND.\n";
+    return out.str();
+}
+
+static const struct {
+    const char* name;
+    std::string (*generate)(unsigned scale);
+} WORKLOADS[] = {
+    { "subprograms", generateSubprograms },
+    { "expressions", generateExpressions },
+    { "declarations", generateDeclarations },
+    { "strings", generateStrings }
+};
+
+// --- Baseline ---
+
+// One figure of a workload run, e.g. "semantic_analysis_ms" or "peak_rss_kb".
+struct Measurement {
+    std::string metric;
+    double value;
+};
+
+// Baseline lines are "<workload> <scanner> <metric> <value>"; '#' starts a
+// comment line. Keyed by "<workload> <scanner> <metric>".
+typedef std::map<std::string, double> Baseline;
+
+// Wall times below this are too noisy to compare against a percentage.
+static const double MIN_COMPARED_MS = 10.0;
+
+static bool loadBaseline(const std::string& path, Baseline& baseline) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Error: Cannot open baseline " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    unsigned number = 0;
+    while (std::getline(in, line)) {
+        number++;
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string workload, scanner, metric;
+        double value;
+        if (!(fields >> workload >> scanner >> metric >> value)) {
+            std::cerr << "Error: " << path << ":" << number << ": malformed baseline line" << std::endl;
+            return false;
+        }
+        baseline[workload + " " + scanner + " " + metric] = value;
+    }
+    return true;
+}
+
+// "semantic analysis" -> "semantic_analysis_ms"
+static std::string phaseMetric(const std::string& phase) {
+    std::string metric = phase;
+    std::replace(metric.begin(), metric.end(), ' ', '_');
+    return metric + "_ms";
+}
+
+// Reports every measurement that exceeds its baseline by more than
+// 'tolerance' percent; returns whether there were none.
+static bool compareWithBaseline(const std::string& prefix, const std::vector<Measurement>& measured,
+    const Baseline& baseline, double tolerance) {
+    bool ok = true;
+    std::string missing;
+    for (const Measurement& measurement : measured) {
+        auto expected = baseline.find(prefix + measurement.metric);
+        if (expected == baseline.end()) {
+            missing += " " + measurement.metric;
+            continue;
+        }
+        bool is_time = measurement.metric.size() > 3
+            && measurement.metric.compare(measurement.metric.size() - 3, 3, "_ms") == 0;
+        if (is_time && expected->second < MIN_COMPARED_MS) continue;
+        double limit = expected->second * (1 + tolerance / 100);
+        if (measurement.value <= limit) continue;
+        std::cout << "REGRESSION: " << prefix << measurement.metric << " " << std::fixed << std::setprecision(2)
+            << measurement.value << ", baseline " << expected->second << " (+"
+            << (measurement.value / expected->second - 1) * 100 << "%, tolerance " << tolerance << "%)" << std::endl;
+        ok = false;
+    }
+    if (!missing.empty()) std::cout << "No baseline for " << prefix << "(" << missing.substr(1) << ")" << std::endl;
+    return ok;
+}
+
+// --- Driver ---
+
+// 12345678 -> "12.3M"
+static std::string humanCount(double value) {
+    static const char* const SUFFIXES[] = { "", "K", "M", "G" };
+    int suffix = 0;
+    while (value >= 1000 && suffix < 3) {
+        value /= 1000;
+        suffix++;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(suffix ? 1 : 0) << value << SUFFIXES[suffix];
+    return out.str();
+}
+
+// Compiles 'source' 'runs' times and keeps, per phase, the fastest run and
+// the largest peak RSS growth (which only the first run tends to show).
+// Appends the per-phase wall times, the total and the process's peak RSS to
+// 'measured'.
+static bool runWorkload(const char* name, const std::string& source, unsigned runs, bool fast_scanner,
+    std::vector<Measurement>& measured) {
+    minipascal::Options options;
+    options.name = std::string(name) + ".pas";
+    options.time_phases = true;
+    options.fast_scanner = fast_scanner;
+
+    std::vector<PhaseStats> best;
+    for (unsigned run = 0; run < runs; run++) {
+        minipascal::Result result = minipascal::compile(source, options);
+        if (!result.ok()) {
+            std::cerr << "Error: workload " << name << " failed to compile ("
+                << compileStatusToString(result.status) << ")" << std::endl << result.diagnostics;
+            return false;
+        }
+        for (const PhaseStats& phase : result.stats.phases) {
+            auto known = std::find_if(best.begin(), best.end(),
+                [&phase](const PhaseStats& b) { return b.name == phase.name; });
+            if (known == best.end()) {
+                best.push_back(phase);
+                continue;
+            }
+            known->wall_ms = std::min(known->wall_ms, phase.wall_ms);
+            known->cpu_ms = std::min(known->cpu_ms, phase.cpu_ms);
+            known->peak_rss_delta_kb = std::max(known->peak_rss_delta_kb, phase.peak_rss_delta_kb);
+        }
+    }
+
+    std::cout << "=== " << name << ": " << source.size() << " bytes, " << (fast_scanner ? "fast" : "flex")
+        << " scanner, best of " << runs << " run" << (runs == 1 ? "" : "s") << " ===" << std::endl;
+    std::cout << std::left << std::setw(20) << "Phase" << std::right << std::setw(12) << "Wall (ms)"
+        << std::setw(12) << "MB/s" << std::setw(14) << "Peak RSS +KB" << "  Throughput" << std::endl;
+    double total_ms = 0;
+    for (const PhaseStats& phase : best) {
+        total_ms += phase.wall_ms;
+        measured.push_back({ phaseMetric(phase.name), phase.wall_ms });
+        double seconds = phase.wall_ms / 1000;
+        std::cout << std::left << std::setw(20) << phase.name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(12) << phase.wall_ms << std::setw(12);
+        // Phases that take next to no time (in-memory output) get no rate.
+        if (phase.wall_ms >= 0.01) std::cout << source.size() / seconds / 1e6;
+        else std::cout << "-";
+        std::cout << std::setw(14) << phase.peak_rss_delta_kb;
+        if (!phase.object_kind.empty() && phase.wall_ms >= 0.01) {
+            std::cout << "  " << humanCount(phase.objects / seconds) << " " << phase.object_kind << "/s ("
+                << phase.objects << ")";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::left << std::setw(20) << "total" << std::right << std::fixed << std::setprecision(2)
+        << std::setw(12) << total_ms << std::setw(12) << (total_ms > 0 ? source.size() / total_ms / 1e3 : 0.0)
+        << std::setw(14) << peakRssKb() << "  (peak RSS of the process, KB)" << std::endl << std::endl;
+    measured.push_back({ "total_ms", total_ms });
+    measured.push_back({ "peak_rss_kb", static_cast<double>(peakRssKb()) });
+    return true;
+}
+
+static void printUsage() {
+    std::cerr << "Usage: ./benchmark [--scale=N] [--runs=N] [--scanner=flex|fast]" << std::endl;
+    std::cerr << "                   [--baseline=FILE [--tolerance=PCT]] [--save-baseline=FILE] [workload ...]" << std::endl;
+    std::cerr << "       ./benchmark [--scale=N] --print <workload>" << std::endl;
+    std::cerr << "Workloads:";
+    for (const auto& workload : WORKLOADS) std::cerr << " " << workload.name;
+    std::cerr << " (default: all)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned scale = 1;
+    unsigned runs = 3;
+    bool fast_scanner = false;
+    bool print = false;
+    std::string baseline_path;
+    std::string save_path;
+    double tolerance = 25;
+    std::vector<std::string> selected;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg.rfind("--scale=", 0) == 0) {
+            scale = static_cast<unsigned>(std::strtoul(arg.c_str() + 8, nullptr, 10));
+        }
+        else if (arg.rfind("--runs=", 0) == 0) {
+            runs = static_cast<unsigned>(std::strtoul(arg.c_str() + 7, nullptr, 10));
+        }
+        else if (arg == "--scanner=flex" || arg == "--scanner=fast") {
+            fast_scanner = arg == "--scanner=fast";
+        }
+        else if (arg.rfind("--baseline=", 0) == 0) {
+            baseline_path = arg.substr(11);
+        }
+        else if (arg.rfind("--save-baseline=", 0) == 0) {
+            save_path = arg.substr(16);
+        }
+        else if (arg.rfind("--tolerance=", 0) == 0) {
+            tolerance = std::strtod(arg.c_str() + 12, nullptr);
+        }
+        else if (arg == "--print") {
+            print = true;
+        }
+        else if (arg.size() > 1 && arg[0] == '-') {
+            printUsage();
+            return 1;
+        }
+        else {
+            selected.push_back(arg);
+        }
+    }
+    for (const std::string& name : selected) {
+        bool known = false;
+        for (const auto& workload : WORKLOADS) known = known || name == workload.name;
+        if (!known) {
+            std::cerr << "Error: Unknown workload " << name << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+    if (scale == 0 || runs == 0 || tolerance < 0 || (print && selected.size() != 1)) {
+        printUsage();
+        return 1;
+    }
+    Baseline baseline;
+    if (!baseline_path.empty() && !print && !loadBaseline(baseline_path, baseline)) return 1;
+    // Figures depend on the size of the programs, so a baseline is only
+    // good for the scale it was taken at.
+    std::ostringstream scale_suffix;
+    if (scale != 1) scale_suffix << "@" << scale;
+    const char* scanner_name = fast_scanner ? "fast" : "flex";
+    bool failed = false;
+
+    for (const auto& workload : WORKLOADS) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), workload.name) == selected.end()) continue;
+        std::string source = workload.generate(scale);
+        if (print) {
+            std::cout << source;
+            return 0;
+        }
+        std::vector<Measurement> measured;
+        if (!runWorkload(workload.name, source, runs, fast_scanner, measured)) return 1;
+
+        std::string prefix = workload.name + scale_suffix.str() + " " + scanner_name + " ";
+        if (!save_path.empty()) {
+            std::ofstream save(save_path, std::ios::app);
+            for (const Measurement& measurement : measured) {
+                save << prefix << measurement.metric << " " << std::fixed << std::setprecision(2)
+                    << measurement.value << "\n";
+            }
+            if (!save) {
+                std::cerr << "Error: Cannot write baseline " << save_path << std::endl;
+                return 1;
+            }
+        }
+        if (!baseline_path.empty() && !compareWithBaseline(prefix, measured, baseline, tolerance)) failed = true;
+    }
+    if (failed) {
+        std::cout << "Slower or bigger than the baseline " << baseline_path << "." << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,542 @@
+#include "cache_directory.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <process.h>
+#define getpid _getpid
+#endif
+
+namespace fs = std::filesystem;
+
+// Envelope of every entry file; the body's own layout is up to its user.
+static const char ENTRY_MAGIC[8] = { 'M', 'P', 'C', 'A', 'C', 'H', 'E', '2' };
+
+struct EntryHeader {
+    char magic[8];
+    unsigned char key[Sha256::DIGEST_SIZE]; // the full CacheKey
+    uint64_t bodyLength;
+    uint64_t bodyHash;    // hashBytes() of the body
+};
+
+// Entries of this age or more that are still temporaries belong to a writer
+// that died; eviction clears them out.
+static const auto STALE_TEMPORARY = std::chrono::hours(1);
+
+uint64_t hashBytes(std::string_view data, uint64_t seed) {
+    uint64_t hash = seed;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// --- SHA-256 ---
+
+static const uint32_t SHA256_ROUND_CONSTANTS[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static uint32_t rotateRight(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+Sha256::Sha256()
+    : state{ 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 } {}
+
+void Sha256::compress(const unsigned char* data) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = static_cast<uint32_t>(data[4 * i]) << 24 | static_cast<uint32_t>(data[4 * i + 1]) << 16 |
+            static_cast<uint32_t>(data[4 * i + 2]) << 8 | data[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+        uint32_t t1 = h + s1 + ((e & f) ^ (~e & g)) + SHA256_ROUND_CONSTANTS[i] + w[i];
+        uint32_t s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+        uint32_t t2 = s0 + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void Sha256::update(std::string_view data) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+    size_t size = data.size();
+    totalBytes += size;
+    if (blockUsed > 0) {
+        size_t take = std::min(size, sizeof block - blockUsed);
+        std::memcpy(block + blockUsed, bytes, take);
+        blockUsed += take;
+        bytes += take;
+        size -= take;
+        if (blockUsed < sizeof block) return;
+        compress(block);
+        blockUsed = 0;
+    }
+    for (; size >= sizeof block; bytes += sizeof block, size -= sizeof block) {
+        compress(bytes);
+    }
+    std::memcpy(block, bytes, size);
+    blockUsed = size;
+}
+
+void Sha256::finish(unsigned char digest[DIGEST_SIZE]) {
+    uint64_t bits = totalBytes * 8;
+    block[blockUsed++] = 0x80;
+    if (blockUsed > 56) {
+        std::memset(block + blockUsed, 0, sizeof block - blockUsed);
+        compress(block);
+        blockUsed = 0;
+    }
+    std::memset(block + blockUsed, 0, 56 - blockUsed);
+    for (int i = 0; i < 8; i++) block[56 + i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+    compress(block);
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 4; j++) digest[4 * i + j] = static_cast<unsigned char>(state[i] >> (24 - 8 * j));
+    }
+}
+
+// --- CacheKey ---
+
+uint64_t CacheKey::fileKey() const {
+    uint64_t key = 0;
+    for (int i = 0; i < 8; i++) key = key << 8 | digest[i];
+    return key;
+}
+
+CacheKeyBuilder& CacheKeyBuilder::add(std::string_view field) {
+    uint64_t length = field.size();
+    hash.update(std::string_view(reinterpret_cast<const char*>(&length), sizeof length));
+    hash.update(field);
+    return *this;
+}
+
+CacheKey CacheKeyBuilder::finish() {
+    CacheKey key;
+    hash.finish(key.digest);
+    return key;
+}
+
+const char* compilerBuildId() {
+    // The Makefile compiles every source in one go, so this dates the whole compiler.
+    return "MiniPascal " __DATE__ " " __TIME__;
+}
+
+// --- CacheEntry ---
+
+CacheEntry::~CacheEntry() {
+    release();
+}
+
+void CacheEntry::release() {
+#ifndef _WIN32
+    if (mapped) munmap(const_cast<char*>(mapped), length);
+#endif
+    mapped = nullptr;
+    length = 0;
+    owned.clear();
+    contents = std::string_view();
+}
+
+bool CacheEntry::open(const std::string& path) {
+    release();
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) return false;
+    mapped = static_cast<const char*>(address);
+    length = static_cast<size_t>(info.st_size);
+    return true;
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::ostringstream text;
+    text << in.rdbuf();
+    owned = text.str();
+    length = owned.size();
+    return length > 0;
+#endif
+}
+
+// --- PendingEntry ---
+
+PendingEntry::~PendingEntry() {
+    if (file) {
+        std::fclose(file);
+        std::remove(tempPath.c_str());
+    }
+}
+
+// --- Locking and the stats file ---
+
+namespace {
+
+// Exclusive lock on DIR/lock for as long as it lives. flock() locks belong to
+// the open file and LockFileEx() locks to the handle, so either way this
+// excludes other threads of the same process as well as other processes.
+// Without the lock file it goes ahead unlocked: the entries themselves never
+// depend on it, only the counters do.
+class DirectoryLock {
+private:
+#ifndef _WIN32
+    int fd;
+#else
+    HANDLE file;
+#endif
+
+public:
+#ifndef _WIN32
+    explicit DirectoryLock(const std::string& dir) : fd(::open((dir + "/lock").c_str(), O_RDWR | O_CREAT, 0644)) {
+        if (fd >= 0) {
+            while (flock(fd, LOCK_EX) != 0 && errno == EINTR) {}
+        }
+    }
+    ~DirectoryLock() {
+        if (fd >= 0) ::close(fd);
+    }
+#else
+    explicit DirectoryLock(const std::string& dir)
+        : file(CreateFileA((dir + "/lock").c_str(), GENERIC_READ | GENERIC_WRITE,
+              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr)) {
+        if (file != INVALID_HANDLE_VALUE) {
+            OVERLAPPED whole = {};
+            LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &whole);
+        }
+    }
+    ~DirectoryLock() {
+        if (file == INVALID_HANDLE_VALUE) return;
+        // Closing the handle frees the lock too, but not necessarily at once
+        OVERLAPPED whole = {};
+        UnlockFileEx(file, 0, 1, 0, &whole);
+        CloseHandle(file);
+    }
+#endif
+
+    DirectoryLock(const DirectoryLock&) = delete;
+    DirectoryLock& operator=(const DirectoryLock&) = delete;
+};
+
+const struct {
+    const char* name;
+    uint64_t CacheStats::* field;
+} STATS_FIELDS[] = {
+    { "result_hits", &CacheStats::resultHits }, { "result_misses", &CacheStats::resultMisses },
+    { "ast_hits", &CacheStats::astHits }, { "ast_misses", &CacheStats::astMisses },
+    { "stores", &CacheStats::stores }, { "evictions", &CacheStats::evictions },
+    { "bytes", &CacheStats::bytes }
+};
+
+// False if there is no stats file yet. 'bytes' is the running estimate of
+// the entries' size, corrected whenever eviction rescans the directory.
+bool readStats(const std::string& dir, CacheStats& stats) {
+    std::ifstream in(dir + "/stats");
+    if (!in) return false;
+    std::string name;
+    uint64_t value;
+    while (in >> name >> value) {
+        for (const auto& field : STATS_FIELDS) {
+            if (name == field.name) stats.*field.field = value;
+        }
+    }
+    return true;
+}
+
+// Puts 'from' in place of 'to'. std::rename() won't replace an existing file
+// on Windows, std::filesystem::rename() does everywhere. A temporary that
+// can't be put in place is deleted rather than left behind.
+bool replaceFile(const std::string& from, const std::string& to) {
+    std::error_code ec;
+    fs::rename(from, to, ec);
+    if (!ec) return true;
+    fs::remove(from, ec);
+    return false;
+}
+
+void writeStats(const std::string& dir, const CacheStats& stats) {
+    std::string temp_path = dir + "/stats.tmp";
+    bool written;
+    {
+        std::ofstream out(temp_path, std::ios::trunc);
+        for (const auto& field : STATS_FIELDS) {
+            out << field.name << ' ' << stats.*field.field << '\n';
+        }
+        written = static_cast<bool>(out);
+    }
+    if (!written) {
+        std::error_code ec;
+        fs::remove(temp_path, ec);
+        return;
+    }
+    replaceFile(temp_path, dir + "/stats");
+}
+
+struct EntryFile {
+    fs::path path;
+    uint64_t size;
+    fs::file_time_type used;
+};
+
+bool isEntryName(const std::string& name) {
+    return name.size() > 4 && name.find(".tmp") == std::string::npos &&
+        (name.compare(name.size() - 4, 4, ".ast") == 0 || name.compare(name.size() - 4, 4, ".res") == 0);
+}
+
+// The entries in 'dir'; stale temporaries are deleted on the way if asked.
+std::vector<EntryFile> scanEntries(const std::string& dir, bool clearStale) {
+    std::vector<EntryFile> entries;
+    std::error_code ec;
+    auto now = fs::file_time_type::clock::now();
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code statError;
+        if (!it->is_regular_file(statError)) continue;
+        std::string name = it->path().filename().string();
+        fs::file_time_type used = it->last_write_time(statError);
+        if (statError) continue;
+        if (isEntryName(name)) {
+            uint64_t size = it->file_size(statError);
+            if (!statError) entries.push_back({ it->path(), size, used });
+        }
+        else if (clearStale && name.find(".tmp") != std::string::npos && now - used > STALE_TEMPORARY) {
+            fs::remove(it->path(), statError);
+        }
+    }
+    return entries;
+}
+
+void addCounts(CacheStats& stats, const CacheStats& counts) {
+    stats.resultHits += counts.resultHits;
+    stats.resultMisses += counts.resultMisses;
+    stats.astHits += counts.astHits;
+    stats.astMisses += counts.astMisses;
+}
+
+uint64_t totalSize(const std::vector<EntryFile>& entries) {
+    uint64_t total = 0;
+    for (const EntryFile& entry : entries) total += entry.size;
+    return total;
+}
+
+} // namespace
+
+// --- CacheDirectory ---
+
+CacheDirectory::CacheDirectory(std::string dir, uint64_t limit) : directory(std::move(dir)), maxBytes(limit) {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+}
+
+CacheDirectory::~CacheDirectory() {
+    flushCounts();
+}
+
+bool CacheDirectory::ok() const {
+    std::error_code ec;
+    return fs::is_directory(directory, ec);
+}
+
+std::string CacheDirectory::entryPath(const CacheKey& key, const char* extension) const {
+    std::ostringstream name;
+    name << directory << '/' << std::hex << std::setw(16) << std::setfill('0') << key.fileKey() << extension;
+    return name.str();
+}
+
+bool CacheDirectory::fetch(const CacheKey& key, const char* extension, CacheEntry& entry) const {
+    std::string path = entryPath(key, extension);
+    if (!entry.open(path)) return false;
+
+    EntryHeader header;
+    if (entry.size() < sizeof header) return false;
+    std::memcpy(&header, entry.data(), sizeof header);
+    std::string_view body(entry.data() + sizeof header, entry.size() - sizeof header);
+    if (std::memcmp(header.magic, ENTRY_MAGIC, sizeof ENTRY_MAGIC) != 0 || std::memcmp(header.key, key.bytes(), sizeof header.key) != 0 ||
+        header.bodyLength != body.size() || header.bodyHash != hashBytes(body)) {
+        return false;
+    }
+    entry.setBody(body);
+
+    // Mark it used; losing this race to an eviction is harmless, the entry
+    // stays mapped.
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+std::unique_ptr<PendingEntry> CacheDirectory::begin(const CacheKey& key, const char* extension) {
+    // Unique per process and per call, so concurrent writers of the same
+    // entry (batch workers, server requests, other processes) never share a
+    // temporary.
+    static std::atomic<unsigned> counter{ 0 };
+    std::string final_path = entryPath(key, extension);
+    std::string temp_path = final_path + ".tmp" + std::to_string(getpid()) + "." + std::to_string(counter++);
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) return nullptr;
+
+    // The header goes in last, once the body's length and checksum are known.
+    EntryHeader header = {};
+    if (std::fwrite(&header, sizeof header, 1, file) != 1) {
+        std::fclose(file);
+        std::remove(temp_path.c_str());
+        return nullptr;
+    }
+    return std::unique_ptr<PendingEntry>(new PendingEntry(key, std::move(temp_path), std::move(final_path), file));
+}
+
+bool CacheDirectory::commit(std::unique_ptr<PendingEntry> entry) {
+    EntryHeader header;
+    std::memcpy(header.magic, ENTRY_MAGIC, sizeof ENTRY_MAGIC);
+    std::memcpy(header.key, entry->key.bytes(), sizeof header.key);
+    header.bodyLength = entry->body.size();
+    header.bodyHash = entry->body.checksum();
+
+    FILE* file = entry->file;
+    entry->file = nullptr;
+    bool written = entry->body.ok() && std::fseek(file, 0, SEEK_SET) == 0 &&
+        std::fwrite(&header, sizeof header, 1, file) == 1;
+    if (std::fclose(file) != 0 || !written) {
+        std::remove(entry->tempPath.c_str());
+        return false;
+    }
+
+    DirectoryLock lock(directory);
+    std::error_code ec;
+    uint64_t replaced = fs::file_size(entry->finalPath, ec);
+    if (ec) replaced = 0;
+    if (!replaceFile(entry->tempPath, entry->finalPath)) return false;
+
+    CacheStats stats;
+    if (!readStats(directory, stats)) {
+        stats.bytes = totalSize(scanEntries(directory, false));
+    }
+    else {
+        uint64_t grown = stats.bytes + sizeof header + header.bodyLength;
+        stats.bytes = grown > replaced ? grown - replaced : 0;
+    }
+    stats.stores++;
+    addCounts(stats, takePending());
+    if (stats.bytes > maxBytes) stats.bytes = evict(stats);
+    writeStats(directory, stats);
+    return true;
+}
+
+uint64_t CacheDirectory::evict(CacheStats& stats) {
+    std::vector<EntryFile> entries = scanEntries(directory, true);
+    std::sort(entries.begin(), entries.end(),
+        [](const EntryFile& a, const EntryFile& b) { return a.used < b.used; });
+
+    // Down to 90%, so the next few stores don't each trigger another scan.
+    uint64_t total = totalSize(entries);
+    uint64_t target = maxBytes / 10 * 9;
+    for (const EntryFile& entry : entries) {
+        if (total <= target) break;
+        std::error_code ec;
+        if (fs::remove(entry.path, ec)) {
+            total -= entry.size;
+            stats.evictions++;
+        }
+    }
+    return total;
+}
+
+void CacheDirectory::count(Counter counter) {
+    std::lock_guard<std::mutex> guard(pendingMutex);
+    switch (counter) {
+    case RESULT_HIT: pending.resultHits++; break;
+    case RESULT_MISS: pending.resultMisses++; break;
+    case AST_HIT: pending.astHits++; break;
+    case AST_MISS: pending.astMisses++; break;
+    }
+}
+
+CacheStats CacheDirectory::takePending() {
+    std::lock_guard<std::mutex> guard(pendingMutex);
+    CacheStats counts = pending;
+    pending = CacheStats();
+    return counts;
+}
+
+void CacheDirectory::flushCounts() {
+    CacheStats counts = takePending();
+    if (counts.resultHits + counts.resultMisses + counts.astHits + counts.astMisses == 0) return;
+    DirectoryLock lock(directory);
+    CacheStats stats;
+    if (!readStats(directory, stats)) {
+        stats.bytes = totalSize(scanEntries(directory, false));
+    }
+    addCounts(stats, counts);
+    writeStats(directory, stats);
+}
+
+CacheStats CacheDirectory::stats() const {
+    DirectoryLock lock(directory);
+    CacheStats stats;
+    readStats(directory, stats);
+    std::vector<EntryFile> entries = scanEntries(directory, false);
+    stats.entries = entries.size();
+    stats.bytes = totalSize(entries);
+    return stats;
+}
+
+static void printRatio(std::ostream& out, const char* what, uint64_t hits, uint64_t misses) {
+    out << "  " << std::left << std::setw(14) << what << hits << " hits, " << misses << " misses";
+    if (hits + misses > 0) {
+        out << " (" << std::fixed << std::setprecision(1) << 100.0 * hits / (hits + misses) << "% hit rate)";
+    }
+    out << std::endl;
+}
+
+void CacheDirectory::printStats(std::ostream& out) const {
+    CacheStats s = stats();
+    out << "Compilation cache " << directory << std::endl;
+    printRatio(out, "results:", s.resultHits, s.resultMisses);
+    printRatio(out, "syntax trees:", s.astHits, s.astMisses);
+    out << "  " << std::left << std::setw(14) << "entries:" << s.entries << ", " << (s.bytes + 1023) / 1024
+        << " KiB of " << maxBytes / 1024 << " KiB" << std::endl;
+    out << "  " << std::left << std::setw(14) << "stores:" << s.stores << ", " << s.evictions << " evicted" << std::endl;
+}
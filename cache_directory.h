@@ -0,0 +1,288 @@
+#ifndef CACHE_DIRECTORY_H
+#define CACHE_DIRECTORY_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 64-bit FNV-1a of 'data', continuing from 'seed'. Only a checksum: it
+// catches damaged entries, not deliberately colliding ones.
+const uint64_t HASH_SEED = 14695981039346656037ull;
+uint64_t hashBytes(std::string_view data, uint64_t seed = HASH_SEED);
+
+// SHA-256, fed in pieces.
+class Sha256 {
+private:
+    uint32_t state[8];
+    unsigned char block[64];
+    size_t blockUsed = 0;
+    uint64_t totalBytes = 0;
+
+    void compress(const unsigned char* data);
+
+public:
+    static const size_t DIGEST_SIZE = 32;
+
+    Sha256();
+    void update(std::string_view data);
+    // Ends the hash; the object is spent afterwards.
+    void finish(unsigned char digest[DIGEST_SIZE]);
+};
+
+// Names a cache entry by a SHA-256 of everything it depends on (the compiler
+// build, the options, the source text). The file name is the first 64 bits;
+// the whole digest is stored in the entry and compared on every fetch, so two
+// keys that share a file name can't be mistaken for each other.
+class CacheKey {
+private:
+    unsigned char digest[Sha256::DIGEST_SIZE] = {};
+    friend class CacheKeyBuilder;
+
+public:
+    const unsigned char* bytes() const { return digest; }
+    uint64_t fileKey() const;
+};
+
+class CacheKeyBuilder {
+private:
+    Sha256 hash;
+
+public:
+    // Adds one piece of key material. Pieces are length-prefixed, so no two
+    // lists of them run together into the same bytes.
+    CacheKeyBuilder& add(std::string_view field);
+    CacheKey finish();
+};
+
+// Identifies this build of the compiler. It goes into every cache key, so a
+// rebuilt compiler never picks up what an older one stored.
+const char* compilerBuildId();
+
+// --- Entry encoding ---
+
+// Writes plain values to an entry body in host byte order (a cache is never
+// shared between machines of different architecture), straight into the
+// entry's file, keeping the body's length and checksum as it goes.
+class CacheWriter {
+private:
+    FILE* file;
+    uint64_t length = 0;
+    uint64_t hash = HASH_SEED;
+    bool failed = false;
+
+public:
+    explicit CacheWriter(FILE* target) : file(target) {}
+
+    void write(const char* data, size_t size) {
+        if (size == 0) return;
+        if (std::fwrite(data, 1, size, file) != size) failed = true;
+        length += size;
+        hash = hashBytes(std::string_view(data, size), hash);
+    }
+
+    template <typename T>
+    void put(T value) {
+        write(reinterpret_cast<const char*>(&value), sizeof value);
+    }
+
+    void putString(std::string_view text) {
+        put(static_cast<uint32_t>(text.size()));
+        write(text.data(), text.size());
+    }
+
+    template <typename T>
+    void putArray(const std::vector<T>& items) {
+        write(reinterpret_cast<const char*>(items.data()), items.size() * sizeof(T));
+    }
+
+    uint64_t size() const { return length; }
+    uint64_t checksum() const { return hash; }
+    bool ok() const { return !failed; }
+};
+
+// Bounds-checked cursor over an entry body; every get fails once the data
+// runs out, so a short or damaged entry can't be read past its end.
+class CacheReader {
+private:
+    const char* cursor;
+    const char* limit;
+
+public:
+    explicit CacheReader(std::string_view data) : cursor(data.data()), limit(data.data() + data.size()) {}
+
+    bool atEnd() const { return cursor == limit; }
+    size_t remaining() const { return static_cast<size_t>(limit - cursor); }
+    const char* position() const { return cursor; }
+
+    bool getBytes(size_t size, const char*& bytes) {
+        if (static_cast<size_t>(limit - cursor) < size) return false;
+        bytes = cursor;
+        cursor += size;
+        return true;
+    }
+
+    template <typename T>
+    bool get(T& value) {
+        const char* bytes;
+        if (!getBytes(sizeof value, bytes)) return false;
+        std::memcpy(&value, bytes, sizeof value);
+        return true;
+    }
+
+    bool getString(std::string_view& text) {
+        uint32_t size;
+        const char* bytes;
+        if (!get(size) || !getBytes(size, bytes)) return false;
+        text = std::string_view(bytes, size);
+        return true;
+    }
+
+    template <typename T>
+    bool getArray(size_t count, std::vector<T>& items) {
+        const char* bytes;
+        if (count > static_cast<size_t>(limit - cursor) / sizeof(T) || !getBytes(count * sizeof(T), bytes)) return false;
+        items.resize(count);
+        if (count) std::memcpy(static_cast<void*>(items.data()), bytes, count * sizeof(T));
+        return true;
+    }
+
+    // Enums are stored as one byte; anything past 'last' fails.
+    template <typename E>
+    bool getEnum(E& value, E last) {
+        uint8_t raw;
+        if (!get(raw) || raw > static_cast<uint8_t>(last)) return false;
+        value = static_cast<E>(raw);
+        return true;
+    }
+};
+
+// A fetched entry, mapped read-only (or read in where mapping isn't
+// available). The body stays valid while the entry lives, even if the file
+// is evicted meanwhile.
+class CacheEntry {
+private:
+    const char* mapped = nullptr;
+    size_t length = 0;
+    std::string owned;
+    std::string_view contents;
+
+    void release();
+
+public:
+    CacheEntry() = default;
+    ~CacheEntry();
+
+    CacheEntry(const CacheEntry&) = delete;
+    CacheEntry& operator=(const CacheEntry&) = delete;
+
+    bool open(const std::string& path);
+    void setBody(std::string_view body) { contents = body; }
+
+    const char* data() const { return mapped ? mapped : owned.data(); }
+    size_t size() const { return length; }
+    std::string_view body() const { return contents; }
+};
+
+// An entry being written, to a temporary file of its own in the directory.
+// CacheDirectory::commit() publishes it; dropping it uncommitted deletes the
+// temporary, so a compilation that fails halfway leaves nothing behind.
+class PendingEntry {
+private:
+    friend class CacheDirectory;
+    CacheKey key;
+    std::string tempPath;
+    std::string finalPath;
+    FILE* file;
+    CacheWriter body;
+
+    PendingEntry(const CacheKey& k, std::string temp, std::string final, FILE* f)
+        : key(k), tempPath(std::move(temp)), finalPath(std::move(final)), file(f), body(f) {}
+
+public:
+    ~PendingEntry();
+
+    PendingEntry(const PendingEntry&) = delete;
+    PendingEntry& operator=(const PendingEntry&) = delete;
+
+    CacheWriter& out() { return body; }
+};
+
+// What --cache-stats reports. The counters are kept in the directory, so
+// they cover every process that used it.
+struct CacheStats {
+    uint64_t resultHits = 0;
+    uint64_t resultMisses = 0;
+    uint64_t astHits = 0;
+    uint64_t astMisses = 0;
+    uint64_t stores = 0;
+    uint64_t evictions = 0;
+    uint64_t entries = 0;
+    uint64_t bytes = 0;
+};
+
+// A directory of cache entries shared by any number of compiler processes
+// (--cache-dir). Each entry is one file named after its CacheKey: written under
+// a temporary name and renamed into place, so readers never need a lock and
+// never see half an entry, and checksummed, so a damaged one is just a miss.
+//
+// The directory is kept under 'maxBytes' by evicting the least recently used
+// entries; a hit refreshes the entry's modification time, which is what
+// "recently used" goes by. The counters and the running size live in a small
+// stats file, updated under an exclusive lock on DIR/lock (flock), which also
+// serializes eviction.
+class CacheDirectory {
+public:
+    enum Counter { RESULT_HIT, RESULT_MISS, AST_HIT, AST_MISS };
+
+private:
+    std::string directory;
+    uint64_t maxBytes;
+    // Hits and misses not yet in the stats file
+    std::mutex pendingMutex;
+    CacheStats pending;
+
+    std::string entryPath(const CacheKey& key, const char* extension) const;
+    // Deletes least recently used entries until the directory is comfortably
+    // under maxBytes; the caller holds the lock. Returns the bytes left.
+    uint64_t evict(CacheStats& stats);
+    // The pending counts, which start over from zero
+    CacheStats takePending();
+
+public:
+    static const uint64_t DEFAULT_MAX_BYTES = 256ull * 1024 * 1024;
+
+    // 'dir' is created if need be; see ok().
+    CacheDirectory(std::string dir, uint64_t maxBytes = DEFAULT_MAX_BYTES);
+    ~CacheDirectory();
+
+    // False if the directory couldn't be created
+    bool ok() const;
+    const std::string& path() const { return directory; }
+
+    // Maps the entry for 'key' into 'entry' and marks it used. False if it
+    // is missing, damaged or stored under another key.
+    bool fetch(const CacheKey& key, const char* extension, CacheEntry& entry) const;
+    // Starts the entry for 'key'; nullptr if its file can't be created.
+    std::unique_ptr<PendingEntry> begin(const CacheKey& key, const char* extension);
+    // Puts 'entry' in place, replacing any entry with its key, and evicts old
+    // entries if the directory grows too big. A failed store costs a later
+    // compilation its shortcut and nothing else, so it only returns false.
+    bool commit(std::unique_ptr<PendingEntry> entry);
+
+    // Counts a lookup. Counts are kept in memory and go into the stats file
+    // with the next commit() or flushCounts(), so a compilation takes the
+    // lock once per entry it stores rather than once per lookup as well.
+    void count(Counter counter);
+    void flushCounts();
+    // Counters, plus the entries and bytes actually on disk
+    CacheStats stats() const;
+    void printStats(std::ostream& out) const;
+};
+
+#endif // CACHE_DIRECTORY_H
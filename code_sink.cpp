@@ -0,0 +1,38 @@
+#include "code_sink.h"
+#include <cstring>
+
+FileCodeSink::FileCodeSink(const std::string& path, size_t bufferSize)
+    : file(std::fopen(path.c_str(), "w")), buffer(bufferSize) {}
+
+FileCodeSink::~FileCodeSink() {
+    finish();
+}
+
+void FileCodeSink::flushBuffer() {
+    if (used > 0 && file && std::fwrite(buffer.data(), 1, used, file) != used) {
+        failed = true;
+    }
+    used = 0;
+}
+
+void FileCodeSink::write(const char* data, size_t size) {
+    if (used + size > buffer.size()) {
+        flushBuffer();
+        if (size > buffer.size()) {
+            // Larger than the whole buffer: write it straight through.
+            if (file && std::fwrite(data, 1, size, file) != size) failed = true;
+            return;
+        }
+    }
+    std::memcpy(buffer.data() + used, data, size);
+    used += size;
+}
+
+bool FileCodeSink::finish() {
+    if (!file) return closed && !failed;
+    flushBuffer();
+    if (std::fclose(file) != 0) failed = true;
+    file = nullptr;
+    closed = true;
+    return !failed;
+}
@@ -0,0 +1,59 @@
+#ifndef CODE_SINK_H
+#define CODE_SINK_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdio>
+
+// Where the CodeGenerator writes the assembly as it is produced, so a program
+// is never held in memory as a whole on its way to the output file.
+class CodeSink {
+public:
+    virtual ~CodeSink() = default;
+
+    virtual void write(const char* data, size_t size) = 0;
+    void write(std::string_view text) { write(text.data(), text.size()); }
+    void put(char c) { write(&c, 1); }
+
+    // Pushes out anything buffered; false if a write failed.
+    virtual bool finish() { return true; }
+};
+
+// Appends to a string, for in-memory compilation.
+class StringCodeSink : public CodeSink {
+private:
+    std::string& target;
+
+public:
+    explicit StringCodeSink(std::string& out) : target(out) {}
+    void write(const char* data, size_t size) override { target.append(data, size); }
+};
+
+// Writes a file through one large buffer and plain fwrite calls.
+class FileCodeSink : public CodeSink {
+private:
+    FILE* file;
+    std::vector<char> buffer;
+    size_t used = 0;
+    bool failed = false;
+    bool closed = false;
+
+    void flushBuffer();
+
+public:
+    static const size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    explicit FileCodeSink(const std::string& path, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    ~FileCodeSink() override;
+
+    FileCodeSink(const FileCodeSink&) = delete;
+    FileCodeSink& operator=(const FileCodeSink&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+    void write(const char* data, size_t size) override;
+    // Flushes and closes the file.
+    bool finish() override;
+};
+
+#endif // CODE_SINK_H
@@ -1,4 +1,5 @@
 #include "codegenerator.h"
+#include "trace.h"
 #include <stdexcept>
 #include <iostream>
 #include <list>
@@ -6,28 +7,49 @@
 
 // --- Entry Point ---
 
-std::string CodeGenerator::generateCode(ProgramNode& ast_root, SemanticAnalyzer& semanticAnalyzer) {
+void CodeGenerator::generateCode(ProgramNode& ast_root, SemanticAnalyzer& semanticAnalyzer, CodeSink& sink) {
     this->symbolTable = &semanticAnalyzer.getSymbolTable();
+    this->code = &sink;
     ast_root.accept(*this);
-    return code.str();
+    this->code = nullptr;
+}
+
+std::string CodeGenerator::generateCode(ProgramNode& ast_root, SemanticAnalyzer& semanticAnalyzer) {
+    std::string assembly;
+    StringCodeSink sink(assembly);
+    generateCode(ast_root, semanticAnalyzer, sink);
+    return assembly;
 }
 
 // --- Helper Methods ---
 
 std::string CodeGenerator::newLabel(const std::string& prefix) {
-    return "L_" + prefix + "_" + std::to_string(labelCounter++);
+    return label(prefix, labelCounter++);
 }
 
-void CodeGenerator::emit(const std::string& instruction) {
-    code << "    " << instruction << std::endl;
+std::string CodeGenerator::label(const std::string& prefix, int number) {
+    return "L_" + prefix + "_" + std::to_string(number);
 }
 
-void CodeGenerator::emit(const std::string& instruction, const std::string& arg) {
-    code << "    " << instruction << " " << arg << std::endl;
+void CodeGenerator::emit(std::string_view instruction) {
+    code->write("    ", 4);
+    code->write(instruction);
+    code->put('\n');
+    instructionCount++;
+}
+
+void CodeGenerator::emit(std::string_view instruction, std::string_view arg) {
+    code->write("    ", 4);
+    code->write(instruction);
+    code->put(' ');
+    code->write(arg);
+    code->put('\n');
+    instructionCount++;
 }
 
 void CodeGenerator::emitLabel(const std::string& label) {
-    code << label << ":" << std::endl;
+    code->write(label);
+    code->write(":\n", 2);
 }
 
 // --- Visitor Implementations ---
@@ -50,7 +72,7 @@ void CodeGenerator::visit(Declarations& node) {
     if (symbolTable->isGlobalScope()) {
         if (!node.var_decl_items.empty()) {
             for (auto* decl : node.var_decl_items) {
-                if (dynamic_cast<ArrayTypeNode*>(decl->type)) continue;
+                if (isa<ArrayTypeNode>(decl->type)) continue;
                 varCount += decl->identifiers->identifiers.size();
             }
             if (varCount > 0) {
@@ -81,15 +103,15 @@ void CodeGenerator::visit(VarDecl& node) {
             emit("pushn", std::to_string(varCount));
         }
     }
-    if (auto* arrayType = dynamic_cast<ArrayTypeNode*>(node.type)) {
-        int low = arrayType->startIndex->value;
-        int high = arrayType->endIndex->value;
+    if (auto* arrayType = dyn_cast<ArrayTypeNode>(node.type)) {
+        int low = static_cast<int>(arrayType->startIndex->value);
+        int high = static_cast<int>(arrayType->endIndex->value);
         int size = high - low + 1;
         if (size <= 0) {
             throw std::runtime_error("Array size must be positive.");
         }
         for (auto* ident : node.identifiers->identifiers) {
-            SymbolEntry* entry = symbolTable->lookupSymbol(ident->name);
+            SymbolEntry* entry = symbolTable->lookupSymbol(ident->id);
             if (!entry) throw std::runtime_error("CodeGen: Symbol not found during array allocation: " + ident->name);
             emit("alloc", std::to_string(size));
             if (symbolTable->isGlobalScope()) {
@@ -111,6 +133,7 @@ void CodeGenerator::visit(SubprogramDeclarations& node) {
 
 // MODIFIED: This function now finds and stores the subprogram's symbol entry for context.
 void CodeGenerator::visit(SubprogramDeclaration& node) {
+    TraceScope span("CodeGenerator::SubprogramDeclaration", "codegen", node.head && node.head->name ? node.head->name->name : std::string());
     SubprogramHead* previousContext = currentFunctionContext;
     currentFunctionContext = node.head;
 
@@ -120,7 +143,7 @@ void CodeGenerator::visit(SubprogramDeclaration& node) {
         // We have to reconstruct the mangled name from the declaration to look it up,
         // since the symbol table is keyed by mangled names for subprograms.
         std::string mangledKey;
-        if (dynamic_cast<FunctionHeadNode*>(node.head)) {
+        if (isa<FunctionHeadNode>(node.head)) {
             mangledKey = "f_" + node.head->name->name;
         }
         else {
@@ -166,7 +189,7 @@ void CodeGenerator::visit(SubprogramDeclaration& node) {
     if (node.local_declarations) node.local_declarations->accept(*this);
     if (node.body) node.body->accept(*this);
 
-    if (dynamic_cast<ProcedureHeadNode*>(node.head)) {
+    if (isa<ProcedureHeadNode>(node.head)) {
         emit("return");
     }
 
@@ -199,62 +222,122 @@ void CodeGenerator::visit(ParameterDeclaration& node) {
     }
 }
 
-void CodeGenerator::visit(CompoundStatementNode& node) {
-    if (node.stmts) node.stmts->accept(*this);
-}
-
-void CodeGenerator::visit(StatementList& node) {
-    for (StatementNode* stmt : node.statements) {
-        if (stmt) stmt->accept(*this);
+// --- Statements and Expressions ---
+// Generated on the AstWalker stack, so deep nesting in the source doesn't
+// nest native calls: visit() starts a walk, resume() emits each node's code
+// in pieces around its children. Label numbers are taken on the first step,
+// in the order a recursive generator would take them.
+
+void CodeGenerator::visit(CompoundStatementNode& node) { walk(&node); }
+void CodeGenerator::visit(StatementList& node) { walk(&node); }
+void CodeGenerator::visit(AssignStatementNode& node) { walk(&node); }
+void CodeGenerator::visit(VariableNode& node) { walk(&node); }
+void CodeGenerator::visit(IfStatementNode& node) { walk(&node); }
+void CodeGenerator::visit(WhileStatementNode& node) { walk(&node); }
+void CodeGenerator::visit(ProcedureCallStatementNode& node) { walk(&node); }
+void CodeGenerator::visit(FunctionCallExprNode& node) { walk(&node); }
+void CodeGenerator::visit(ReturnStatementNode& node) { walk(&node); }
+void CodeGenerator::visit(UnaryOpNode& node) { walk(&node); }
+void CodeGenerator::visit(BinaryOpNode& node) { walk(&node); }
+
+Node* CodeGenerator::resume(Frame& frame) {
+    Node* node = frame.node;
+    switch (node->getKind()) {
+    case NodeKind::COMPOUND_STATEMENT:
+        return frame.step++ == 0 ? cast<CompoundStatementNode>(node)->stmts : nullptr;
+    case NodeKind::STATEMENT_LIST:
+        return nextElement(cast<StatementList>(node)->statements, frame);
+    case NodeKind::ASSIGN_STATEMENT:
+        return resumeAssign(*cast<AssignStatementNode>(node), frame);
+    case NodeKind::VARIABLE:
+        return resumeVariable(*cast<VariableNode>(node), frame);
+    case NodeKind::IF_STATEMENT:
+        return resumeIf(*cast<IfStatementNode>(node), frame);
+    case NodeKind::WHILE_STATEMENT:
+        return resumeWhile(*cast<WhileStatementNode>(node), frame);
+    case NodeKind::PROCEDURE_CALL:
+        return resumeProcedureCall(*cast<ProcedureCallStatementNode>(node), frame);
+    case NodeKind::FUNCTION_CALL:
+        return resumeFunctionCall(*cast<FunctionCallExprNode>(node), frame);
+    case NodeKind::RETURN_STATEMENT:
+        return resumeReturn(*cast<ReturnStatementNode>(node), frame);
+    case NodeKind::UNARY_OP:
+        return resumeUnaryOp(*cast<UnaryOpNode>(node), frame);
+    case NodeKind::BINARY_OP:
+        return resumeBinaryOp(*cast<BinaryOpNode>(node), frame);
+    default:
+        // Identifiers, literals and argument lists (which their calls walk
+        // themselves): nothing to step through
+        node->accept(*this);
+        return nullptr;
     }
 }
 
-void CodeGenerator::visit(AssignStatementNode& node) {
-    if (auto* varNode = dynamic_cast<VariableNode*>(node.variable)) {
+Node* CodeGenerator::resumeAssign(AssignStatementNode& node, Frame& frame) {
+    auto* varNode = dyn_cast<VariableNode>(node.variable);
+    if (!varNode) return nullptr;
+    // Steps 1-2: element at a computed index, 3: element at a constant index
+    // (both with the lower bound in frame.scratch), 4: scalar
+    switch (frame.step) {
+    case 0:
         if (varNode->index) {
-            SymbolEntry* arrayEntry = symbolTable->lookupSymbol(varNode->identifier->name);
+            SymbolEntry* arrayEntry = symbolTable->lookupSymbol(varNode->identifier->id);
             if (!arrayEntry) throw std::runtime_error("CodeGen: Array symbol not found: " + varNode->identifier->name);
-            int lowerBound = arrayEntry->arrayDetails.lowBound;
+            frame.scratch = arrayEntry->arrayDetails.lowBound;
 
             if (varNode->scope == SymbolScope::LOCAL) emit("pushl", std::to_string(varNode->offset));
             else emit("pushg", std::to_string(varNode->offset));
 
-            if (auto* index_lit = dynamic_cast<IntNumNode*>(varNode->index)) {
-                node.expression->accept(*this);
-                emit("store", std::to_string(index_lit->value - lowerBound));
-            }
-            else {
-                varNode->index->accept(*this);
-                emit("pushi", std::to_string(lowerBound));
-                emit("sub");
-                node.expression->accept(*this);
-                emit("storen");
-            }
-        }
-        else {
-            node.expression->accept(*this);
-            if (varNode->determinedType == EntryTypeCategory::PRIMITIVE_REAL && node.expression->determinedType == EntryTypeCategory::PRIMITIVE_INTEGER) {
-                emit("itof");
-            }
-            SymbolEntry* entry = symbolTable->lookupSymbol(varNode->identifier->name);
-            if (!entry) throw std::runtime_error("CodeGen: Symbol not found in assignment: " + varNode->identifier->name);
-            if (entry->kind == SymbolKind::PARAMETER) {
-                emit("storel", std::to_string(-(entry->offset + 1)));
-            }
-            else {
-                if (varNode->scope == SymbolScope::LOCAL) emit("storel", std::to_string(entry->offset));
-                else emit("storeg", std::to_string(entry->offset));
+            if (isa<IntNumNode>(varNode->index)) {
+                frame.step = 3;
+                return node.expression;
             }
+            frame.step = 1;
+            return varNode->index;
         }
+        frame.step = 4;
+        return node.expression;
+    case 1:
+        emit("pushi", std::to_string(frame.scratch));
+        emit("sub");
+        frame.step = 2;
+        return node.expression;
+    case 2:
+        emit("storen");
+        return nullptr;
+    case 3:
+        emit("store", std::to_string(cast<IntNumNode>(varNode->index)->value - frame.scratch));
+        return nullptr;
+    }
+
+    if (varNode->determinedType == EntryTypeCategory::PRIMITIVE_REAL && node.expression->determinedType == EntryTypeCategory::PRIMITIVE_INTEGER) {
+        emit("itof");
+    }
+    SymbolEntry* entry = symbolTable->lookupSymbol(varNode->identifier->id);
+    if (!entry) throw std::runtime_error("CodeGen: Symbol not found in assignment: " + varNode->identifier->name);
+    if (entry->kind == SymbolKind::PARAMETER) {
+        emit("storel", std::to_string(-(entry->offset + 1)));
     }
+    else {
+        if (varNode->scope == SymbolScope::LOCAL) emit("storel", std::to_string(entry->offset));
+        else emit("storeg", std::to_string(entry->offset));
+    }
+    return nullptr;
 }
 
-void CodeGenerator::visit(VariableNode& node) {
-    SymbolEntry* entry = symbolTable->lookupSymbol(node.identifier->name);
+Node* CodeGenerator::resumeVariable(VariableNode& node, Frame& frame) {
+    if (frame.step == 1) { // computed index on the stack; lower bound in frame.scratch
+        emit("pushi", std::to_string(frame.scratch));
+        emit("sub");
+        emit("loadn");
+        return nullptr;
+    }
+
+    SymbolEntry* entry = symbolTable->lookupSymbol(node.identifier->id);
     if (!entry) throw std::runtime_error("CodeGen: Symbol not found: " + node.identifier->name);
     if (entry->kind == SymbolKind::PARAMETER) {
         emit("pushl", std::to_string(-(entry->offset + 1)));
-        return;
+        return nullptr;
     }
     if (node.index) {
         if (!entry->arrayDetails.isInitialized) throw std::runtime_error("CodeGen: Array details not found for " + node.identifier->name);
@@ -262,20 +345,20 @@ void CodeGenerator::visit(VariableNode& node) {
         if (node.scope == SymbolScope::LOCAL) emit("pushl", std::to_string(entry->offset));
         else emit("pushg", std::to_string(entry->offset));
 
-        if (auto* index_lit = dynamic_cast<IntNumNode*>(node.index)) {
+        if (auto* index_lit = dyn_cast<IntNumNode>(node.index)) {
             emit("load", std::to_string(index_lit->value - lowerBound));
         }
         else {
-            node.index->accept(*this);
-            emit("pushi", std::to_string(lowerBound));
-            emit("sub");
-            emit("loadn");
+            frame.step = 1;
+            frame.scratch = lowerBound;
+            return node.index;
         }
     }
     else {
         if (node.scope == SymbolScope::LOCAL) emit("pushl", std::to_string(entry->offset));
         else emit("pushg", std::to_string(entry->offset));
     }
+    return nullptr;
 }
 
 void CodeGenerator::visit(IdExprNode& node) {
@@ -287,7 +370,7 @@ void CodeGenerator::visit(IdExprNode& node) {
         return;
     }
 
-    SymbolEntry* entry = symbolTable->lookupSymbol(node.ident->name);
+    SymbolEntry* entry = symbolTable->lookupSymbol(node.ident->id);
     if (!entry) throw std::runtime_error("CodeGen: Symbol not found for identifier: " + node.ident->name);
 
     if (entry->kind == SymbolKind::PARAMETER) {
@@ -301,152 +384,225 @@ void CodeGenerator::visit(IdExprNode& node) {
     }
 }
 
-void CodeGenerator::visit(IfStatementNode& node) {
-    std::string elseLabel = newLabel("ELSE");
-    std::string endIfLabel = newLabel("END_IF");
-    node.condition->accept(*this);
-    emit("jz", elseLabel);
-    node.thenStatement->accept(*this);
-    if (node.elseStatement) emit("jump", endIfLabel);
-    emitLabel(elseLabel);
-    if (node.elseStatement) node.elseStatement->accept(*this);
-    emitLabel(endIfLabel);
+// frame.scratch: number of the ELSE label; END_IF is the next one
+Node* CodeGenerator::resumeIf(IfStatementNode& node, Frame& frame) {
+    switch (frame.step) {
+    case 0:
+        frame.scratch = labelCounter;
+        labelCounter += 2;
+        frame.step = 1;
+        return node.condition;
+    case 1:
+        emit("jz", label("ELSE", frame.scratch));
+        frame.step = 2;
+        return node.thenStatement;
+    case 2:
+        if (node.elseStatement) emit("jump", label("END_IF", frame.scratch + 1));
+        emitLabel(label("ELSE", frame.scratch));
+        frame.step = 3;
+        if (node.elseStatement) return node.elseStatement;
+        [[fallthrough]];
+    case 3:
+        emitLabel(label("END_IF", frame.scratch + 1));
+    }
+    return nullptr;
 }
 
-void CodeGenerator::visit(WhileStatementNode& node) {
-    std::string loopStartLabel = newLabel("WHILE_START");
-    std::string loopEndLabel = newLabel("WHILE_END");
-    emitLabel(loopStartLabel);
-    node.condition->accept(*this);
-    emit("jz", loopEndLabel);
-    node.body->accept(*this);
-    emit("jump", loopStartLabel);
-    emitLabel(loopEndLabel);
+// frame.scratch: number of the WHILE_START label; WHILE_END is the next one
+Node* CodeGenerator::resumeWhile(WhileStatementNode& node, Frame& frame) {
+    switch (frame.step) {
+    case 0:
+        frame.scratch = labelCounter;
+        labelCounter += 2;
+        emitLabel(label("WHILE_START", frame.scratch));
+        frame.step = 1;
+        return node.condition;
+    case 1:
+        emit("jz", label("WHILE_END", frame.scratch + 1));
+        frame.step = 2;
+        return node.body;
+    }
+    emit("jump", label("WHILE_START", frame.scratch));
+    emitLabel(label("WHILE_END", frame.scratch + 1));
+    return nullptr;
 }
 
-void CodeGenerator::visit(ProcedureCallStatementNode& node) {
-    const std::string& procName = node.procName->name;
-    if (procName == "write" || procName == "writeln") {
-        if (node.arguments && !node.arguments->expressions.empty()) {
-            for (auto* arg : node.arguments->expressions) {
-                arg->accept(*this);
-                if (dynamic_cast<StringLiteralNode*>(arg)) emit("writes");
-                else if (arg->determinedType == EntryTypeCategory::PRIMITIVE_INTEGER || arg->determinedType == EntryTypeCategory::PRIMITIVE_BOOLEAN) emit("writei");
-                else if (arg->determinedType == EntryTypeCategory::PRIMITIVE_REAL) emit("writef");
-            }
+// frame.step counts the arguments pushed so far.
+Node* CodeGenerator::resumeProcedureCall(ProcedureCallStatementNode& node, Frame& frame) {
+    SymbolId procId = node.procName->id;
+    if (procId == SYM_WRITE || procId == SYM_WRITELN) {
+        // Each argument is written as soon as it is on the stack
+        if (frame.step > 0) {
+            ExprNode* arg = node.arguments->expressions[frame.step - 1];
+            if (isa<StringLiteralNode>(arg)) emit("writes");
+            else if (arg->determinedType == EntryTypeCategory::PRIMITIVE_INTEGER || arg->determinedType == EntryTypeCategory::PRIMITIVE_BOOLEAN) emit("writei");
+            else if (arg->determinedType == EntryTypeCategory::PRIMITIVE_REAL) emit("writef");
         }
-        if (procName == "writeln") {
+        if (node.arguments && frame.step < node.arguments->expressions.size()) {
+            return node.arguments->expressions[frame.step++];
+        }
+        if (procId == SYM_WRITELN) {
             emit("pushs", "\"\n\"");
             emit("writes");
         }
-        return;
+        return nullptr;
     }
-    if (procName == "read" || procName == "readln") {
+    if (procId == SYM_READ || procId == SYM_READLN) {
         // ... (read/readln logic is complex and remains unchanged for now)
-        return;
+        return nullptr;
     }
 
     if (!node.resolved_entry) {
-        throw std::runtime_error("CodeGen Error: Procedure call to '" + procName + "' was not resolved by semantic analyzer.");
+        throw std::runtime_error("CodeGen Error: Procedure call to '" + node.procName->name + "' was not resolved by semantic analyzer.");
     }
 
-    std::string mangledName = node.resolved_entry->getMangledName();
-    if (node.arguments) {
-        auto& exprs = node.arguments->expressions;
-        for (auto it = exprs.rbegin(); it != exprs.rend(); ++it) (*it)->accept(*this);
+    // Arguments go on the stack last to first
+    size_t argumentCount = node.arguments ? node.arguments->expressions.size() : 0;
+    if (frame.step < argumentCount) {
+        return node.arguments->expressions[argumentCount - ++frame.step];
     }
-    emit("pusha", mangledName);
+    emit("pusha", node.resolved_entry->getMangledName());
     emit("call");
     if (node.resolved_entry->numParameters > 0) {
         emit("pop", std::to_string(node.resolved_entry->numParameters));
     }
+    return nullptr;
 }
 
-void CodeGenerator::visit(FunctionCallExprNode& node) {
-    if (!node.resolved_entry) {
-        throw std::runtime_error("CodeGen Error: Function call to '" + node.funcName->name + "' was not resolved by semantic analyzer.");
+// frame.step counts the arguments pushed so far.
+Node* CodeGenerator::resumeFunctionCall(FunctionCallExprNode& node, Frame& frame) {
+    if (frame.step == 0) {
+        if (!node.resolved_entry) {
+            throw std::runtime_error("CodeGen Error: Function call to '" + node.funcName->name + "' was not resolved by semantic analyzer.");
+        }
+        emit("pushn", "1");
     }
-    std::string mangledName = node.resolved_entry->getMangledName();
-    emit("pushn", "1");
-    if (node.arguments) {
-        auto& exprs = node.arguments->expressions;
-        for (auto it = exprs.rbegin(); it != exprs.rend(); ++it) (*it)->accept(*this);
+    // Arguments go on the stack last to first
+    size_t argumentCount = node.arguments ? node.arguments->expressions.size() : 0;
+    if (frame.step < argumentCount) {
+        return node.arguments->expressions[argumentCount - ++frame.step];
     }
-    emit("pusha", mangledName);
+    emit("pusha", node.resolved_entry->getMangledName());
     emit("call");
     if (node.resolved_entry->numParameters > 0) {
         emit("pop", std::to_string(node.resolved_entry->numParameters));
     }
+    return nullptr;
 }
 
 // MODIFIED: Corrected logic to use the new context pointer 'currentSubprogramEntry'
-void CodeGenerator::visit(ReturnStatementNode& node) {
+Node* CodeGenerator::resumeReturn(ReturnStatementNode& node, Frame& frame) {
     if (node.returnValue) {
-        if (!currentSubprogramEntry) {
-            throw std::runtime_error("CodeGen: Return statement found with no subprogram context.");
+        if (frame.step == 0) {
+            if (!currentSubprogramEntry) {
+                throw std::runtime_error("CodeGen: Return statement found with no subprogram context.");
+            }
+            frame.step = 1;
+            return node.returnValue;
         }
 
         int num_params = currentSubprogramEntry->numParameters;
-        node.returnValue->accept(*this);
-
         if (currentSubprogramEntry->functionReturnType == EntryTypeCategory::PRIMITIVE_REAL && node.returnValue->determinedType == EntryTypeCategory::PRIMITIVE_INTEGER) {
             emit("itof");
         }
         emit("storel", std::to_string(-(num_params + 1)));
     }
     emit("return");
+    return nullptr;
 }
 
 void CodeGenerator::visit(IntNumNode& node) { emit("pushi", std::to_string(node.value)); }
 void CodeGenerator::visit(RealNumNode& node) { emit("pushf", std::to_string(node.value)); }
 void CodeGenerator::visit(BooleanLiteralNode& node) { emit("pushi", node.value ? "1" : "0"); }
-void CodeGenerator::visit(StringLiteralNode& node) { emit("pushs", "\"" + node.value + "\""); }
-
-void CodeGenerator::visit(UnaryOpNode& node) {
-    node.expression->accept(*this);
-    if (node.op == "-") {
+void CodeGenerator::visit(StringLiteralNode& node) { emit("pushs", "\"" + std::string(node.value) + "\""); }
+
+Node* CodeGenerator::resumeUnaryOp(UnaryOpNode& node, Frame& frame) {
+    if (frame.step++ == 0) {
+        // A negated literal is pushed as it is: -2147483648 only fits in an
+        // integer with its sign.
+        IntNumNode* literal = node.op == UnaryOperator::NEG ? dyn_cast<IntNumNode>(node.expression) : nullptr;
+        if (!literal) return node.expression;
+        emit("pushi", std::to_string(-literal->value));
+        return nullptr;
+    }
+    switch (node.op) {
+    case UnaryOperator::NEG:
         if (node.expression->determinedType == EntryTypeCategory::PRIMITIVE_REAL) {
             emit("pushf", "0.0"); emit("swap"); emit("fsub");
         }
         else {
             emit("pushi", "0"); emit("swap"); emit("sub");
         }
-    }
-    else if (node.op == "NOT_OP") {
+        break;
+    case UnaryOperator::NOT:
         emit("not");
+        break;
     }
+    return nullptr;
 }
 
-void CodeGenerator::visit(BinaryOpNode& node) {
-    bool is_real_op = (node.left->determinedType == EntryTypeCategory::PRIMITIVE_REAL ||
-        node.right->determinedType == EntryTypeCategory::PRIMITIVE_REAL ||
-        node.op == "/");
-    if (node.op == "AND_OP" || node.op == "OR_OP") is_real_op = false;
-    node.left->accept(*this);
-    if (is_real_op && node.left->determinedType == EntryTypeCategory::PRIMITIVE_INTEGER) emit("itof");
-    node.right->accept(*this);
+// --- Binary Operator Opcodes ---
+
+struct Instruction {
+    const char* opcode;     // nullptr ends a sequence
+    const char* arg;
+};
+
+// How a binary operator picks between its integer and real instruction sequences
+enum class OperandMode { BY_OPERANDS, ALWAYS_REAL, ALWAYS_INTEGER };
+
+struct BinaryOpcodes {
+    OperandMode mode;
+    Instruction integer[3];
+    Instruction real[3];
+};
+
+// Indexed by BinaryOperator
+static const BinaryOpcodes binaryOpcodes[BINARY_OPERATOR_COUNT] = {
+    /* ADD      */ { OperandMode::BY_OPERANDS,    { { "add" } },    { { "fadd" } } },
+    /* SUB      */ { OperandMode::BY_OPERANDS,    { { "sub" } },    { { "fsub" } } },
+    /* MUL      */ { OperandMode::BY_OPERANDS,    { { "mul" } },    { { "fmul" } } },
+    /* REAL_DIV */ { OperandMode::ALWAYS_REAL,    { { "fdiv" } },   { { "fdiv" } } },
+    /* INT_DIV  */ { OperandMode::BY_OPERANDS,    { { "div" } },    { { "div" } } },
+    /* AND      */ { OperandMode::ALWAYS_INTEGER, { { "mul" } },    { { "mul" } } },
+    /* OR       */ { OperandMode::ALWAYS_INTEGER, { { "add" }, { "pushi", "0" }, { "sup" } }, { { "add" }, { "pushi", "0" }, { "sup" } } },
+    /* EQ       */ { OperandMode::BY_OPERANDS,    { { "equal" } },  { { "equal" } } },
+    /* NEQ      */ { OperandMode::BY_OPERANDS,    { { "equal" }, { "not" } }, { { "equal" }, { "not" } } },
+    /* LT       */ { OperandMode::BY_OPERANDS,    { { "inf" } },    { { "finf" } } },
+    /* LTE      */ { OperandMode::BY_OPERANDS,    { { "infeq" } },  { { "finfeq" } } },
+    /* GT       */ { OperandMode::BY_OPERANDS,    { { "sup" } },    { { "fsup" } } },
+    /* GTE      */ { OperandMode::BY_OPERANDS,    { { "supeq" } },  { { "fsupeq" } } },
+};
+
+Node* CodeGenerator::resumeBinaryOp(BinaryOpNode& node, Frame& frame) {
+    const BinaryOpcodes& opcodes = binaryOpcodes[static_cast<size_t>(node.op)];
+    bool is_real_op = opcodes.mode == OperandMode::ALWAYS_REAL ||
+        (opcodes.mode == OperandMode::BY_OPERANDS &&
+            (node.left->determinedType == EntryTypeCategory::PRIMITIVE_REAL ||
+             node.right->determinedType == EntryTypeCategory::PRIMITIVE_REAL));
+    switch (frame.step) {
+    case 0:
+        frame.step = 1;
+        return node.left;
+    case 1:
+        if (is_real_op && node.left->determinedType == EntryTypeCategory::PRIMITIVE_INTEGER) emit("itof");
+        frame.step = 2;
+        return node.right;
+    }
     if (is_real_op && node.right->determinedType == EntryTypeCategory::PRIMITIVE_INTEGER) emit("itof");
 
-    if (node.op == "+") emit(is_real_op ? "fadd" : "add");
-    else if (node.op == "-") emit(is_real_op ? "fsub" : "sub");
-    else if (node.op == "*") emit(is_real_op ? "fmul" : "mul");
-    else if (node.op == "/") emit("fdiv");
-    else if (node.op == "DIV_OP") emit("div");
-    else if (node.op == "EQ_OP") emit("equal");
-    else if (node.op == "NEQ_OP") { emit("equal"); emit("not"); }
-    else if (node.op == "LT_OP") emit(is_real_op ? "finf" : "inf");
-    else if (node.op == "LTE_OP") emit(is_real_op ? "finfeq" : "infeq");
-    else if (node.op == "GT_OP") emit(is_real_op ? "fsup" : "sup");
-    else if (node.op == "GTE_OP") emit(is_real_op ? "fsupeq" : "supeq");
-    else if (node.op == "AND_OP") emit("mul");
-    else if (node.op == "OR_OP") { emit("add"); emit("pushi", "0"); emit("sup"); }
-    else throw std::runtime_error("CodeGen: Unsupported binary op '" + node.op + "'");
+    for (const Instruction& instruction : is_real_op ? opcodes.real : opcodes.integer) {
+        if (!instruction.opcode) break;
+        if (instruction.arg) emit(instruction.opcode, instruction.arg);
+        else emit(instruction.opcode);
+    }
+    return nullptr;
 }
 
 EntryTypeCategory CodeGenerator::astToSymbolType(TypeNode* astTypeNode, ArrayDetails& outArrayDetails) {
     outArrayDetails.isInitialized = false;
     if (!astTypeNode) return EntryTypeCategory::UNKNOWN_TYPE;
-    if (auto* stn = dynamic_cast<StandardTypeNode*>(astTypeNode)) {
+    if (auto* stn = dyn_cast<StandardTypeNode>(astTypeNode)) {
         switch (stn->category) {
         case StandardTypeNode::TYPE_INTEGER: return EntryTypeCategory::PRIMITIVE_INTEGER;
         case StandardTypeNode::TYPE_REAL: return EntryTypeCategory::PRIMITIVE_REAL;
@@ -454,7 +610,7 @@ EntryTypeCategory CodeGenerator::astToSymbolType(TypeNode* astTypeNode, ArrayDet
         default: return EntryTypeCategory::UNKNOWN_TYPE;
         }
     }
-    else if (auto* atn = dynamic_cast<ArrayTypeNode*>(astTypeNode)) {
+    else if (auto* atn = dyn_cast<ArrayTypeNode>(astTypeNode)) {
         if (atn->elementType) {
             switch (atn->elementType->category) {
             case StandardTypeNode::TYPE_INTEGER: outArrayDetails.elementType = EntryTypeCategory::PRIMITIVE_INTEGER; break;
@@ -464,8 +620,8 @@ EntryTypeCategory CodeGenerator::astToSymbolType(TypeNode* astTypeNode, ArrayDet
             }
         }
         if (atn->startIndex && atn->endIndex) {
-            outArrayDetails.lowBound = atn->startIndex->value;
-            outArrayDetails.highBound = atn->endIndex->value;
+            outArrayDetails.lowBound = static_cast<int>(atn->startIndex->value);
+            outArrayDetails.highBound = static_cast<int>(atn->endIndex->value);
             outArrayDetails.isInitialized = true;
         }
         return EntryTypeCategory::ARRAY;
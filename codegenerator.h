@@ -4,18 +4,27 @@
 #include "ast.h"
 #include "semantic_analyzer.h" 
 #include "symbol_table.h" 
+#include "code_sink.h"
+#include "ast_walker.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sstream>
 #include <map>
 
-class CodeGenerator : public SemanticVisitor {
+class CodeGenerator : public SemanticVisitor, private AstWalker {
 public:
+    // Streams the program's assembly into 'sink' as it is generated.
+    void generateCode(ProgramNode& ast_root, SemanticAnalyzer& semanticAnalyzer, CodeSink& sink);
+    // Convenience for callers that want the whole program as a string.
     std::string generateCode(ProgramNode& ast_root, SemanticAnalyzer& semanticAnalyzer);
+    // Instructions emitted so far (labels not included), for --time-report
+    size_t getInstructionCount() const { return instructionCount; }
 
 private:
-    std::stringstream code;
+    CodeSink* code = nullptr;
     int labelCounter = 0;
+    size_t instructionCount = 0;
     SymbolTable* symbolTable = nullptr;
     SubprogramHead* currentFunctionContext = nullptr;
     // ADDED: A pointer to the symbol entry for the current subprogram being generated.
@@ -28,11 +37,25 @@ private:
 
     // Helper Methods
     std::string newLabel(const std::string& prefix);
-    void emit(const std::string& instruction);
-    void emit(const std::string& instruction, const std::string& arg);
+    // The label newLabel(prefix) returned when labelCounter was 'number'
+    std::string label(const std::string& prefix, int number);
+    void emit(std::string_view instruction);
+    void emit(std::string_view instruction, std::string_view arg);
     void emitLabel(const std::string& label);
     EntryTypeCategory astToSymbolType(TypeNode* astTypeNode, ArrayDetails& outArrayDetails);
 
+    // Statements and expressions, one step at a time (see AstWalker)
+    Node* resume(Frame& frame) override;
+    Node* resumeAssign(AssignStatementNode& node, Frame& frame);
+    Node* resumeVariable(VariableNode& node, Frame& frame);
+    Node* resumeIf(IfStatementNode& node, Frame& frame);
+    Node* resumeWhile(WhileStatementNode& node, Frame& frame);
+    Node* resumeProcedureCall(ProcedureCallStatementNode& node, Frame& frame);
+    Node* resumeFunctionCall(FunctionCallExprNode& node, Frame& frame);
+    Node* resumeReturn(ReturnStatementNode& node, Frame& frame);
+    Node* resumeUnaryOp(UnaryOpNode& node, Frame& frame);
+    Node* resumeBinaryOp(BinaryOpNode& node, Frame& frame);
+
     // Visitor Method Overrides
     void visit(ProgramNode& node) override;
     void visit(Declarations& node) override;
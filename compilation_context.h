@@ -0,0 +1,75 @@
+#ifndef COMPILATION_CONTEXT_H
+#define COMPILATION_CONTEXT_H
+
+#include "token_buffer.h"
+#include "source_buffer.h"
+#include "interner.h"
+#include "arena.h"
+#include <string>
+#include <iostream>
+
+class ProgramNode;
+class TimeReport;
+class TraceRecorder;
+class CacheDirectory;
+
+// Artifacts a compilation writes (--emit). Phases after the last requested
+// artifact don't run at all, so the flags are ordered like the pipeline.
+enum EmitFlags : unsigned {
+    EMIT_TOKENS = 1 << 0,
+    EMIT_AST = 1 << 1,
+    EMIT_SEMA = 1 << 2,
+    EMIT_ASM = 1 << 3,
+    EMIT_ALL = EMIT_TOKENS | EMIT_AST | EMIT_SEMA | EMIT_ASM
+};
+
+// Which scanner phase 1 runs (--scanner). Both produce the same tokens.
+enum ScannerKind {
+    SCANNER_FLEX,   // lexer.l
+    SCANNER_FAST    // fast_scanner.cpp
+};
+
+// Everything one compilation needs that used to live in process globals
+// (lin/col, yylval, yyin, root_ast_node, compilation_has_error). The reentrant
+// scanner reaches it through yyextra and the pure parser through its parse-param,
+// so several compilations can run in the same process at once.
+struct CompilationContext {
+    std::string input_filename;
+    std::string base_name;
+    std::string output_dir;
+    unsigned emit = EMIT_ASM;
+    ScannerKind scanner = SCANNER_FLEX;
+
+    // Scanner position, kept up to date by the lexer rules
+    int lin = 1;
+    int col = 1;
+    int comment_start_lin = 0;
+    int comment_start_col = 0;
+
+    // The text being compiled; tokens point into it, so it lives as long as they do
+    SourceBuffer source;
+    // Identifier spellings, interned once by the lexer
+    StringInterner names;
+    // Holds the AST; the whole tree is freed with it
+    Arena arena;
+    TokenBuffer tokens;
+    ProgramNode* root_ast_node = nullptr;
+
+    // Set by the lexer or parser on error
+    bool has_error = false;
+
+    // Where progress messages and diagnostics go. Batch mode points these at
+    // per-file buffers so concurrent compilations don't interleave their output.
+    std::ostream* out = &std::cout;
+    std::ostream* err = &std::cerr;
+
+    // When set, every phase adds its cost here (--time-report)
+    TimeReport* time_report = nullptr;
+    // When set, phases and analyzer internals are recorded as trace events (--trace)
+    TraceRecorder* trace = nullptr;
+    // When set, results and analyzed programs are looked up here first and
+    // stored here after (--cache-dir)
+    CacheDirectory* cache = nullptr;
+};
+
+#endif // COMPILATION_CONTEXT_H
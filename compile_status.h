@@ -0,0 +1,28 @@
+#ifndef COMPILE_STATUS_H
+#define COMPILE_STATUS_H
+
+#include <string>
+
+// How far a compilation got
+enum class CompileStatus {
+    SUCCESS,
+    IO_ERROR,
+    LEXICAL_ERROR,
+    SYNTAX_ERROR,
+    SEMANTIC_ERROR,
+    CODEGEN_ERROR
+};
+
+inline std::string compileStatusToString(CompileStatus status) {
+    switch (status) {
+    case CompileStatus::SUCCESS: return "OK";
+    case CompileStatus::IO_ERROR: return "I/O error";
+    case CompileStatus::LEXICAL_ERROR: return "lexical errors";
+    case CompileStatus::SYNTAX_ERROR: return "syntax errors";
+    case CompileStatus::SEMANTIC_ERROR: return "semantic errors";
+    case CompileStatus::CODEGEN_ERROR: return "code generation failed";
+    default: return "unknown";
+    }
+}
+
+#endif // COMPILE_STATUS_H
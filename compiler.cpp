@@ -0,0 +1,409 @@
+#include "compiler.h"
+#include "ast.h"
+#include "parser.h"
+#include "lexer.h"
+#include "fast_scanner.h"
+#include "semantic_analyzer.h"
+#include "codegenerator.h"
+#include "ast_cache.h"
+#include "result_cache.h"
+#include "time_report.h"
+#include "trace.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <memory>
+
+// Helper function to get the base name of a file path
+std::string get_base_filename(const std::string& path) {
+    size_t last_slash = path.find_last_of("/\\");
+    std::string filename = (last_slash == std::string::npos) ? path : path.substr(last_slash + 1);
+    size_t last_dot = filename.find_last_of('.');
+    return (last_dot == std::string::npos) ? filename : filename.substr(0, last_dot);
+}
+
+static const struct {
+    const char* name;
+    EmitFlags flag;
+} EMIT_NAMES[] = {
+    { "tokens", EMIT_TOKENS }, { "ast", EMIT_AST }, { "sema", EMIT_SEMA }, { "asm", EMIT_ASM }
+};
+
+bool parseEmitList(const std::string& list, unsigned& emit) {
+    emit = 0;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) comma = list.size();
+        std::string name = list.substr(start, comma - start);
+        bool known = false;
+        for (const auto& entry : EMIT_NAMES) {
+            if (name == entry.name) {
+                emit |= entry.flag;
+                known = true;
+            }
+        }
+        if (!known) return false;
+        start = comma + 1;
+    }
+    return emit != 0;
+}
+
+std::string emitListToString(unsigned emit) {
+    std::string list;
+    for (const auto& entry : EMIT_NAMES) {
+        if (emit & entry.flag) {
+            if (!list.empty()) list += ",";
+            list += entry.name;
+        }
+    }
+    return list;
+}
+
+bool parseScannerName(const std::string& name, ScannerKind& scanner) {
+    if (name == "flex") scanner = SCANNER_FLEX;
+    else if (name == "fast") scanner = SCANNER_FAST;
+    else return false;
+    return true;
+}
+
+const char* scannerName(ScannerKind scanner) {
+    return scanner == SCANNER_FAST ? "fast" : "flex";
+}
+
+// Artifact names, appended to the base name of the input
+static const char* const TOKENS_SUFFIX = ".tokens.txt";
+static const char* const AST_SUFFIX = ".ast.txt";
+static const char* const SEMANTICS_SUFFIX = ".semantic_analysis.log";
+static const char* const ASSEMBLY_SUFFIX = ".assembly.vm";
+
+// =============================================
+// PHASE 1: LEXICAL ANALYSIS
+// =============================================
+static bool runLexicalAnalysis(CompilationContext& ctx, ArtifactStore& artifacts) {
+    TraceScope span("Lexical Analysis", "phase");
+    *ctx.out << "Phase 1: Lexical Analysis..." << std::endl;
+    {
+        PhaseTimer timer(ctx.time_report, "lexing");
+        if (ctx.scanner == SCANNER_FAST) tokenizeFast(ctx.source, ctx);
+        else tokenize(ctx.source, ctx);
+        timer.setObjects(ctx.tokens.size(), "tokens");
+    }
+
+    if (ctx.emit & EMIT_TOKENS) {
+        PhaseTimer timer(ctx.time_report, "output writing");
+        std::ostream* tokens_file = artifacts.open(TOKENS_SUFFIX);
+        if (!tokens_file) {
+            *ctx.err << "Error: Could not open tokens output file." << std::endl;
+            return false;
+        }
+        ctx.tokens.dump(*tokens_file, ctx.names);
+        artifacts.close(TOKENS_SUFFIX);
+    }
+
+    if (ctx.has_error) {
+        *ctx.err << "Lexical analysis failed." << std::endl;
+        return false;
+    }
+    *ctx.out << "Lexical analysis successful.";
+    if (ctx.emit & EMIT_TOKENS) *ctx.out << " Token list written to " << artifacts.location(TOKENS_SUFFIX);
+    *ctx.out << std::endl;
+    return true;
+}
+
+// =============================================
+// PHASE 2: SYNTAX ANALYSIS (PARSING)
+// =============================================
+static bool runSyntaxAnalysis(CompilationContext& ctx, ArtifactStore& artifacts) {
+    TraceScope span("Syntax Analysis", "phase");
+    *ctx.out << "\nPhase 2: Syntax Analysis..." << std::endl;
+    int parse_result;
+    {
+        PhaseTimer timer(ctx.time_report, "parsing");
+        size_t nodes_before = Node::createdOnThisThread();
+        parse_result = yyparse(&ctx);
+        timer.setObjects(Node::createdOnThisThread() - nodes_before, "AST nodes");
+    }
+
+    if (parse_result != 0 || ctx.root_ast_node == nullptr) {
+        *ctx.err << "Syntax analysis failed." << std::endl;
+        return false;
+    }
+    if (ctx.has_error) {
+        // The parser recovered from every error (see parser.y), so there is a
+        // tree for semantic analysis to check, but none worth dumping.
+        *ctx.err << "Syntax analysis failed. Continuing with the recovered tree." << std::endl;
+        return true;
+    }
+    *ctx.out << "Parsing successful!" << std::endl;
+
+    if (ctx.emit & EMIT_AST) {
+        if (std::ostream* ast_file = artifacts.open(AST_SUFFIX)) {
+            PhaseTimer timer(ctx.time_report, "ast dump");
+            ctx.root_ast_node->print(*ast_file);
+            artifacts.close(AST_SUFFIX);
+        }
+        *ctx.out << "AST dump written to " << artifacts.location(AST_SUFFIX) << std::endl;
+    }
+    return true;
+}
+
+// =============================================
+// PHASE 3: SEMANTIC ANALYSIS
+// =============================================
+// 'recovered' says the tree came from syntax error recovery; it is analyzed
+// all the same, but never reported as a success.
+static bool runSemanticAnalysis(CompilationContext& ctx, ArtifactStore& artifacts, SemanticAnalyzer& semanticAnalyzer,
+    bool recovered) {
+    TraceScope span("Semantic Analysis", "phase");
+    *ctx.out << "\nPhase 3: Semantic Analysis..." << std::endl;
+    {
+        PhaseTimer timer(ctx.time_report, "semantic analysis");
+        ctx.root_ast_node->accept(semanticAnalyzer);
+        timer.setObjects(semanticAnalyzer.getSymbolTable().getSymbolCount(), "symbols");
+    }
+
+    bool ok = !semanticAnalyzer.hasErrors();
+    const char* success = recovered ? "Semantic analysis of the recovered tree found no further errors."
+                                    : "Semantic analysis successful!";
+    if (!(ctx.emit & EMIT_SEMA)) {
+        // No log requested: the errors themselves are the diagnostics.
+        if (!ok) {
+            *ctx.err << "Semantic analysis failed." << std::endl;
+            semanticAnalyzer.printErrors(*ctx.err);
+        }
+        else {
+            *ctx.out << success << std::endl;
+        }
+        return ok;
+    }
+
+    PhaseTimer timer(ctx.time_report, "output writing");
+    std::ostream* semantics_file = artifacts.open(SEMANTICS_SUFFIX);
+    std::ostream discard(nullptr);
+    if (!semantics_file) semantics_file = &discard;
+
+    if (!ok) {
+        *ctx.err << "Semantic analysis failed. See log for details." << std::endl;
+        *semantics_file << "--- SEMANTIC ERRORS ---" << std::endl;
+        semanticAnalyzer.printErrors(*semantics_file);
+    }
+    else {
+        *ctx.out << success << std::endl;
+        if (recovered) {
+            *semantics_file << "No semantic errors found in the tree recovered from the syntax errors." << std::endl;
+        }
+        else {
+            *semantics_file << "Semantic analysis successful. No errors found." << std::endl;
+        }
+    }
+    artifacts.close(SEMANTICS_SUFFIX);
+    return ok;
+}
+
+// =============================================
+// PHASE 4: CODE GENERATION
+// =============================================
+static bool runCodeGeneration(CompilationContext& ctx, ArtifactStore& artifacts, SemanticAnalyzer& semanticAnalyzer) {
+    TraceScope span("Code Generation", "phase");
+    *ctx.out << "\nPhase 4: Code Generation..." << std::endl;
+    std::unique_ptr<CodeSink> vm_file = artifacts.openSink(ASSEMBLY_SUFFIX);
+    if (!vm_file) {
+        *ctx.err << "Error: Could not open assembly output file." << std::endl;
+        return false;
+    }
+
+    // The assembly streams into the sink as it is generated, so the program
+    // never exists in memory as a whole.
+    CodeGenerator codeGenerator;
+    try {
+        PhaseTimer timer(ctx.time_report, "code generation");
+        codeGenerator.generateCode(*ctx.root_ast_node, semanticAnalyzer, *vm_file);
+        timer.setObjects(codeGenerator.getInstructionCount(), "instructions");
+    }
+    catch (const std::runtime_error& e) {
+        vm_file.reset();
+        artifacts.discard(ASSEMBLY_SUFFIX);
+        *ctx.err << "Code generation crashed: " << e.what() << std::endl;
+        return false;
+    }
+
+    bool written;
+    {
+        PhaseTimer timer(ctx.time_report, "output writing");
+        written = vm_file->finish();
+    }
+    if (!written) {
+        artifacts.discard(ASSEMBLY_SUFFIX);
+        *ctx.err << "Error: Could not write assembly output file." << std::endl;
+        return false;
+    }
+    std::string vm_filepath = artifacts.location(ASSEMBLY_SUFFIX);
+    *ctx.out << "Code generation successful! Assembly written to " << vm_filepath << std::endl;
+    *ctx.out << "Run with: ./vm.exe " << vm_filepath << std::endl;
+    return true;
+}
+
+// =============================================
+// PHASES 1-3 FROM THE CACHE (--cache-dir)
+// =============================================
+// Compiles a program whose analysis 'cache' already holds, straight from code
+// generation. False on a miss, leaving nothing behind that the full pipeline
+// would mind.
+static bool runFromAstCache(CompilationContext& ctx, ArtifactStore& artifacts, const AstCache& cache, CompileStatus& status) {
+    CachedAnalysis cached;
+    {
+        TraceScope span("AST Cache", "phase");
+        PhaseTimer timer(ctx.time_report, "cache lookup");
+        if (!cache.load(ctx.names, cached)) return false;
+        timer.setObjects(cached.ast.size(), "AST nodes");
+    }
+    *ctx.out << "Phases 1-3: Reusing cached analysis from " << ctx.cache->path() << std::endl;
+
+    // The analyzer enters its built-ins itself; the code generator only needs
+    // the rest of the global scope back on top of them.
+    SemanticAnalyzer semanticAnalyzer(ctx.names);
+    SymbolTable& symbols = semanticAnalyzer.getSymbolTable();
+    for (const SymbolEntry& entry : cached.globals) {
+        symbols.addSymbol(entry);
+    }
+    ctx.root_ast_node = cached.ast.toTree(ctx.arena, ctx.names, &symbols);
+
+    status = runCodeGeneration(ctx, artifacts, semanticAnalyzer) ? CompileStatus::SUCCESS : CompileStatus::CODEGEN_ERROR;
+    ctx.root_ast_node = nullptr;
+    return true;
+}
+
+// Runs the phases on ctx.source, up to the last one whose artifact is in ctx.emit.
+static CompileStatus runPipeline(CompilationContext& ctx, ArtifactStore& artifacts) {
+    // Keyed by the text as read: the scanner works on the buffer in place.
+    std::unique_ptr<AstCache> cache;
+    if (ctx.cache) {
+        cache.reset(new AstCache(*ctx.cache, std::string_view(ctx.source.data(), ctx.source.size())));
+    }
+    CompileStatus status = CompileStatus::SUCCESS;
+    // Only a plain compile can skip phases; the other artifacts come from them.
+    if (cache && ctx.emit == EMIT_ASM && runFromAstCache(ctx, artifacts, *cache, status)) {
+        return status;
+    }
+
+    if (!runLexicalAnalysis(ctx, artifacts)) {
+        return ctx.has_error ? CompileStatus::LEXICAL_ERROR : CompileStatus::IO_ERROR;
+    }
+    if (ctx.emit < EMIT_AST) {
+        return CompileStatus::SUCCESS;
+    }
+    if (!runSyntaxAnalysis(ctx, artifacts)) {
+        return CompileStatus::SYNTAX_ERROR;
+    }
+    // A recovered tree is only analyzed, for the diagnostics: it never gets
+    // compiled or cached.
+    bool recovered = ctx.has_error;
+
+    if (ctx.emit >= EMIT_SEMA) {
+        SemanticAnalyzer semanticAnalyzer(ctx.names);
+        if (!runSemanticAnalysis(ctx, artifacts, semanticAnalyzer, recovered)) {
+            status = CompileStatus::SEMANTIC_ERROR;
+        }
+        else if (recovered) {
+            if (ctx.emit & EMIT_ASM) *ctx.err << "Code generation skipped because of the syntax errors." << std::endl;
+        }
+        else {
+            if (cache) {
+                // Before code generation, which adds scopes of its own. Failing
+                // to store only costs the next compilation its shortcut.
+                PhaseTimer timer(ctx.time_report, "cache store");
+                cache->store(ctx.names, *ctx.root_ast_node, semanticAnalyzer.getSymbolTable());
+            }
+            if ((ctx.emit & EMIT_ASM) && !runCodeGeneration(ctx, artifacts, semanticAnalyzer)) {
+                status = CompileStatus::CODEGEN_ERROR;
+            }
+        }
+    }
+
+    if (recovered) {
+        status = CompileStatus::SYNTAX_ERROR;
+    }
+
+    // --- Cleanup ---
+    // The tree lives in ctx.arena and is released with it, in one go, when the
+    // context goes away (each batch file and server request has its own).
+    ctx.root_ast_node = nullptr;
+
+    return status;
+}
+
+// Replays an earlier run of the same compilation from ctx.cache. A miss runs
+// the pipeline as usual, with the log and the artifacts recorded into a new
+// entry as they stream out, and stores the entry unless the compilation
+// failed on I/O.
+static CompileStatus runCached(CompilationContext& ctx, ArtifactStore& artifacts) {
+    ResultCache cache(*ctx.cache, ctx);
+    StoredResult stored;
+    bool hit;
+    {
+        TraceScope lookup("Result Cache", "phase");
+        PhaseTimer timer(ctx.time_report, "cache lookup");
+        hit = cache.load(stored, artifacts);
+    }
+
+    if (hit) {
+        for (const auto& chunk : stored.transcript) {
+            *(chunk.first ? ctx.err : ctx.out) << chunk.second << std::flush;
+        }
+        PhaseTimer timer(ctx.time_report, "output writing");
+        std::string failed;
+        if (!stored.writeArtifacts(artifacts, failed)) {
+            *ctx.err << "Error: Could not write " << artifacts.location(failed) << std::endl;
+            return CompileStatus::IO_ERROR;
+        }
+        return stored.status;
+    }
+
+    std::unique_ptr<ResultRecorder> recorder = cache.record(artifacts);
+    Transcript transcript;
+    std::ostream* out = ctx.out;
+    std::ostream* err = ctx.err;
+    TranscriptBuf log_buf(transcript, false, out);
+    TranscriptBuf diagnostics_buf(transcript, true, err);
+    std::ostream log(&log_buf);
+    std::ostream diagnostics(&diagnostics_buf);
+    ctx.out = &log;
+    ctx.err = &diagnostics;
+    CompileStatus status = recorder ? runPipeline(ctx, *recorder) : runPipeline(ctx, artifacts);
+    ctx.out = out;
+    ctx.err = err;
+
+    if (recorder && status != CompileStatus::IO_ERROR) {
+        PhaseTimer timer(ctx.time_report, "cache store");
+        recorder->finish(status, transcript);
+    }
+    return status;
+}
+
+static CompileStatus runPhases(CompilationContext& ctx, ArtifactStore& artifacts) {
+    TraceActivation tracing(ctx.trace);
+    TraceScope span("compile", "driver", ctx.input_filename);
+    if (!ctx.cache) {
+        return runPipeline(ctx, artifacts);
+    }
+    CompileStatus status = runCached(ctx, artifacts);
+    // What the stores didn't already write out (all of it, on a hit)
+    ctx.cache->flushCounts();
+    return status;
+}
+
+CompileStatus compileFile(CompilationContext& ctx) {
+    // --- Map input file ---
+    if (!ctx.source.loadFile(ctx.input_filename)) {
+        *ctx.err << "Error: Could not open file " << ctx.input_filename << std::endl;
+        return CompileStatus::IO_ERROR;
+    }
+    FileArtifactStore artifacts(ctx.output_dir, ctx.base_name);
+    return runPhases(ctx, artifacts);
+}
+
+CompileStatus compileSource(CompilationContext& ctx, std::string_view source, ArtifactStore& artifacts) {
+    ctx.source.assign(source);
+    return runPhases(ctx, artifacts);
+}
@@ -0,0 +1,31 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "compilation_context.h"
+#include "artifact_store.h"
+#include "compile_status.h"
+#include <string>
+#include <string_view>
+
+// Helper function to get the base name of a file path
+std::string get_base_filename(const std::string& path);
+
+// Parses an --emit list such as "tokens,asm" into EmitFlags; false on an
+// unknown or missing name.
+bool parseEmitList(const std::string& list, unsigned& emit);
+// Inverse of parseEmitList
+std::string emitListToString(unsigned emit);
+
+// "flex" or "fast", as given to --scanner; false on anything else.
+bool parseScannerName(const std::string& name, ScannerKind& scanner);
+const char* scannerName(ScannerKind scanner);
+
+// Compiles ctx.input_filename, writing the artifacts selected by ctx.emit to
+// ctx.output_dir (which must exist) and all messages to ctx.out / ctx.err.
+CompileStatus compileFile(CompilationContext& ctx);
+
+// Same pipeline for source text already in memory, with the artifacts written
+// to 'artifacts' instead of ctx.output_dir.
+CompileStatus compileSource(CompilationContext& ctx, std::string_view source, ArtifactStore& artifacts);
+
+#endif // COMPILER_H
@@ -0,0 +1,347 @@
+#include "fast_scanner.h"
+#include "compilation_context.h"
+#include "ast.h"
+#include "parser.h"
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FAST_SCANNER_SSE2 1
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// --- Keywords ---
+
+namespace {
+
+struct Keyword {
+    const char* text; // lower case, as lexer.l spells it
+    unsigned length;
+    int token;
+};
+
+const Keyword KEYWORDS[] = {
+    { "program", 7, PROGRAM }, { "var", 3, VAR }, { "integer", 7, INTEGER_TYPE }, { "real", 4, REAL_TYPE },
+    { "function", 8, FUNCTION }, { "procedure", 9, PROCEDURE }, { "while", 5, WHILE }, { "do", 2, DO },
+    { "begin", 5, BEGIN_TOKEN }, { "end", 3, END_TOKEN }, { "if", 2, IF }, { "then", 4, THEN },
+    { "else", 4, ELSE }, { "array", 5, ARRAY }, { "of", 2, OF }, { "div", 3, DIV_OP },
+    { "not", 3, NOT_OP }, { "or", 2, OR_OP }, { "and", 3, AND_OP }, { "boolean", 7, BOOLEAN_TYPE },
+    { "true", 4, TRUE_KEYWORD }, { "false", 5, FALSE_KEYWORD }, { "return", 6, RETURN_KEYWORD }
+};
+const unsigned KEYWORD_SLOTS = 64;
+
+// Keywords are caseless. OR-ing in 0x20 lower-cases a letter and leaves
+// digits alone; '_' turns into 0x7F, which no keyword contains, so comparing
+// folded identifier bytes against the keyword text is exact.
+constexpr unsigned fold(unsigned char c) { return c | 0x20u; }
+
+// Collision-free over KEYWORDS (checked below): first and last letter plus
+// the length tell all 23 apart.
+constexpr unsigned keywordHash(unsigned char first, unsigned char last, unsigned length) {
+    return (fold(first) + fold(last) + 13 * length) % KEYWORD_SLOTS;
+}
+
+struct KeywordTable {
+    signed char slots[KEYWORD_SLOTS] = {}; // index into KEYWORDS + 1, 0 for none
+    bool perfect = true;
+};
+
+constexpr KeywordTable buildKeywordTable() {
+    KeywordTable table;
+    for (unsigned i = 0; i < sizeof KEYWORDS / sizeof KEYWORDS[0]; i++) {
+        const Keyword& keyword = KEYWORDS[i];
+        unsigned slot = keywordHash(keyword.text[0], keyword.text[keyword.length - 1], keyword.length);
+        if (table.slots[slot] != 0) table.perfect = false;
+        table.slots[slot] = static_cast<signed char>(i + 1);
+    }
+    return table;
+}
+
+constexpr KeywordTable KEYWORD_TABLE = buildKeywordTable();
+static_assert(KEYWORD_TABLE.perfect, "keywordHash() has to keep every keyword in a slot of its own");
+
+// Token kind of the keyword spelled 'text', or 0 for a plain identifier.
+int keywordToken(const char* text, unsigned length) {
+    if (length < 2 || length > 9) return 0;
+    int slot = KEYWORD_TABLE.slots[keywordHash(text[0], text[length - 1], length)];
+    if (slot == 0) return 0;
+    const Keyword& keyword = KEYWORDS[slot - 1];
+    if (keyword.length != length) return 0;
+    for (unsigned i = 0; i < length; i++) {
+        if (fold(static_cast<unsigned char>(text[i])) != static_cast<unsigned char>(keyword.text[i])) return 0;
+    }
+    return keyword.token;
+}
+
+// --- Byte classes ---
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+bool isIdentStart(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+bool isIdentChar(char c) { return isIdentStart(c) || isDigit(c); }
+
+template <size_t N>
+bool inSet(char c, const char (&set)[N]) {
+    for (char member : set) {
+        if (c == member) return true;
+    }
+    return false;
+}
+
+#ifdef FAST_SCANNER_SSE2
+unsigned lowestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+// First byte in [p, end) that is in 'set' (Stop) or that isn't (!Stop); end
+// if there is none. Sixteen bytes per compare where SSE2 is available.
+template <bool Stop, size_t N>
+const char* scanBytes(const char* p, const char* end, const char (&set)[N]) {
+#ifdef FAST_SCANNER_SSE2
+    __m128i members[N];
+    for (size_t i = 0; i < N; i++) members[i] = _mm_set1_epi8(set[i]);
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_cmpeq_epi8(chunk, members[0]);
+        for (size_t i = 1; i < N; i++) hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, members[i]));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (!Stop) mask ^= 0xFFFFu;
+        if (mask) return p + lowestBit(mask);
+        p += 16;
+    }
+#endif
+    while (p < end && inSet(*p, set) != Stop) p++;
+    return p;
+}
+
+const char BLANKS[] = { ' ', '\t' };
+const char LINE_BREAKS[] = { '\n', '\r' };
+const char COMMENT_STOPS[] = { '{', '}', '\n', '\r' };
+
+// --- Scanner ---
+
+class FastScanner {
+private:
+    const char* p;
+    const char* const end;
+    CompilationContext& ctx;
+
+    // After [eE][-+]?digits at 'q', or 'q' itself if there is no exponent
+    const char* exponentEnd(const char* q) const;
+    // Steps over \r\n, \n or \r at p
+    void lineBreak();
+    // Skips a { } comment, p being just past the '{'. False at end of input.
+    bool skipComment();
+
+    int scanNumber(YYSTYPE& value);
+    int scanIdentifier(YYSTYPE& value);
+    int scanString(YYSTYPE& value);
+    int unexpected();
+
+    // Consumes 'length' bytes of a token of kind 'token'
+    int take(unsigned length, int token) {
+        p += length;
+        ctx.col += static_cast<int>(length);
+        return token;
+    }
+
+public:
+    FastScanner(const char* text, size_t length, CompilationContext& context)
+        : p(text), end(text + length), ctx(context) {}
+
+    // Next token, 0 at end of input; ctx.lin/col end up right after it.
+    int next(YYSTYPE& value);
+};
+
+const char* FastScanner::exponentEnd(const char* q) const {
+    if (*q != 'e' && *q != 'E') return q;
+    const char* digits = q + 1;
+    if (*digits == '+' || *digits == '-') digits++;
+    if (!isDigit(*digits)) return q;
+    while (isDigit(*digits)) digits++;
+    return digits;
+}
+
+void FastScanner::lineBreak() {
+    p += (p[0] == '\r' && p[1] == '\n') ? 2 : 1;
+    ctx.lin++;
+    ctx.col = 1;
+}
+
+bool FastScanner::skipComment() {
+    for (;;) {
+        const char* stop = scanBytes<true>(p, end, COMMENT_STOPS);
+        ctx.col += static_cast<int>(stop - p);
+        p = stop;
+        if (p == end) {
+            *ctx.err << "Lexical Error: Unterminated comment from L" << ctx.comment_start_lin << ", C" << ctx.comment_start_col << std::endl;
+            return false;
+        }
+        if (*p == '}') {
+            take(1, 0);
+            return true;
+        }
+        if (*p == '{') {
+            *ctx.err << "Warning: Nested comment '{' at L" << ctx.lin << ", C" << ctx.col << std::endl;
+            take(1, 0);
+        }
+        else {
+            lineBreak();
+        }
+    }
+}
+
+int FastScanner::scanNumber(YYSTYPE& value) {
+    const char* start = p;
+    int start_col = ctx.col;
+    const char* q = p;
+    while (isDigit(*q)) q++;
+
+    // The same longest match flex makes between NUM and the REAL_LITERAL
+    // forms 1.5e3, 1.e3, .5e3 and 1e3.
+    bool real = true;
+    if (q == start || (*q == '.' && isDigit(q[1]))) {
+        q++;
+        while (isDigit(*q)) q++;
+        q = exponentEnd(q);
+    }
+    else if (*q == '.' && exponentEnd(q + 1) != q + 1) {
+        q = exponentEnd(q + 1);
+    }
+    else if (exponentEnd(q) != q) {
+        q = exponentEnd(q);
+    }
+    else {
+        real = false;
+    }
+
+    std::string_view text(start, static_cast<size_t>(q - start));
+    if (real) {
+        double number = 0.0;
+        if (std::from_chars(text.data(), text.data() + text.size(), number).ec != std::errc()) {
+            *ctx.err << "Lexical Error (L:" << ctx.lin << ", C:" << start_col << "): Real literal '" << text << "' is out of range" << std::endl;
+            ctx.has_error = true;
+        }
+        value.real_token = RealToken{ number, ctx.lin, start_col };
+    }
+    else {
+        int64_t number = 0;
+        if (std::from_chars(text.data(), text.data() + text.size(), number).ec != std::errc()) {
+            *ctx.err << "Lexical Error (L:" << ctx.lin << ", C:" << start_col << "): Integer literal '" << text << "' is out of range" << std::endl;
+            ctx.has_error = true;
+        }
+        value.int_token = IntToken{ number, ctx.lin, start_col };
+    }
+    return take(static_cast<unsigned>(text.size()), real ? REAL_LITERAL : NUM);
+}
+
+int FastScanner::scanIdentifier(YYSTYPE& value) {
+    const char* q = p + 1;
+    while (isIdentChar(*q)) q++;
+    unsigned length = static_cast<unsigned>(q - p);
+    if (int keyword = keywordToken(p, length)) return take(length, keyword);
+    value.ident = IdentToken{ ctx.names.intern(std::string_view(p, length)), ctx.lin, ctx.col };
+    return take(length, IDENT);
+}
+
+int FastScanner::scanString(YYSTYPE& value) {
+    // '...' with backslash escapes, all on one line; anything else leaves the
+    // quote as a stray character, as in lexer.l.
+    const char* q = p + 1;
+    for (;;) {
+        if (q >= end || *q == '\n') return unexpected();
+        if (*q == '\'') break;
+        if (*q == '\\') {
+            if (q + 1 >= end || q[1] == '\n') return unexpected();
+            q += 2;
+        }
+        else {
+            q++;
+        }
+    }
+    unsigned length = static_cast<unsigned>(q + 1 - p);
+    value.str_span = SourceSpan{ p + 1, static_cast<int>(length - 2), ctx.lin, ctx.col };
+    return take(length, STRING_LITERAL);
+}
+
+int FastScanner::unexpected() {
+    *ctx.err << "Lexical Error (L:" << ctx.lin << ", C:" << ctx.col << "): Unexpected character '" << *p << "'" << std::endl;
+    take(1, 0);
+    return -1;
+}
+
+int FastScanner::next(YYSTYPE& value) {
+    while (p < end) {
+        char c = *p;
+        switch (c) {
+        case ' ': case '\t': {
+            const char* stop = scanBytes<false>(p, end, BLANKS);
+            ctx.col += static_cast<int>(stop - p);
+            p = stop;
+            continue;
+        }
+        case '\n': case '\r':
+            lineBreak();
+            continue;
+        case '{':
+            ctx.comment_start_lin = ctx.lin;
+            ctx.comment_start_col = ctx.col;
+            take(1, 0);
+            if (!skipComment()) return 0;
+            continue;
+        case '/':
+            if (p[1] == '/') {
+                const char* stop = scanBytes<true>(p + 2, end, LINE_BREAKS);
+                ctx.col += static_cast<int>(stop - p);
+                p = stop;
+                continue;
+            }
+            return take(1, '/');
+        case '\'': {
+            int token = scanString(value);
+            if (token < 0) continue;
+            return token;
+        }
+        case ':': return p[1] == '=' ? take(2, ASSIGN_OP) : take(1, ':');
+        case '<':
+            if (p[1] == '>') return take(2, NEQ_OP);
+            if (p[1] == '=') return take(2, LTE_OP);
+            return take(1, LT_OP);
+        case '>': return p[1] == '=' ? take(2, GTE_OP) : take(1, GT_OP);
+        case '=': return take(1, EQ_OP);
+        case '.':
+            if (isDigit(p[1])) return scanNumber(value);
+            return p[1] == '.' ? take(2, DOTDOT) : take(1, '.');
+        case '+': case '-': case '*': case '(': case ')': case '[': case ']': case ';': case ',':
+            return take(1, c);
+        default:
+            if (isDigit(c)) return scanNumber(value);
+            if (isIdentStart(c)) return scanIdentifier(value);
+            unexpected();
+            continue;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+void tokenizeFast(SourceBuffer& source, CompilationContext& ctx) {
+    FastScanner scanner(source.data(), source.size(), ctx);
+    YYSTYPE value{};
+    int token;
+    while ((token = scanner.next(value)) != 0) {
+        ctx.tokens.append(token, ctx.lin, ctx.col, value);
+    }
+    ctx.tokens.finish(ctx.lin, ctx.col);
+}
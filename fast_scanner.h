@@ -0,0 +1,19 @@
+#ifndef FAST_SCANNER_H
+#define FAST_SCANNER_H
+
+#include "source_buffer.h"
+
+struct CompilationContext;
+
+// Hand-written scanner, selected with --scanner=fast. It fills ctx.tokens with
+// the same tokens, positions and diagnostics as tokenize() in lexer.l, but
+// skips blanks and comments 16 bytes at a time (SSE2, with a plain loop where
+// that isn't available) and looks keywords up in a perfect hash instead of
+// running every identifier through the DFA. `make scanner-check` compares the
+// two over Tests/ and Tests_with_errors/.
+//
+// Like the flex scanner it relies on the two NULs after the text, and
+// STRING_LITERAL tokens point into 'source'.
+void tokenizeFast(SourceBuffer& source, CompilationContext& ctx);
+
+#endif // FAST_SCANNER_H
@@ -0,0 +1,554 @@
+#include "flat_ast.h"
+#include <cstring>
+#include <initializer_list>
+
+// --- Flattening ---
+
+namespace {
+
+// VARIABLE / ID_EXPR payload: the SymbolKind and SymbolScope the analyzer bound
+uint64_t packBinding(SymbolKind kind, SymbolScope scope) {
+    return static_cast<uint64_t>(kind) | static_cast<uint64_t>(scope) << 8;
+}
+
+// Nodes are numbered as they come off an explicit stack, children pushed last
+// to first, which is pre-order without recursing into deep trees.
+class Flattener {
+private:
+    FlatAst& ast;
+
+    // A node still to add and the slot in 'children' that gets its index
+    struct Pending {
+        const Node* node;
+        size_t slot;
+    };
+    static const size_t NO_SLOT = ~size_t(0);
+    std::vector<Pending> pending;
+
+    template <typename List>
+    void addList(NodeIndex index, const List& items) {
+        size_t start = reserveChildren(index, items.size());
+        for (size_t i = items.size(); i-- > 0;) {
+            if (items[i]) pending.push_back({ items[i], start + i });
+        }
+    }
+
+    void addChildren(NodeIndex index, std::initializer_list<const Node*> items) {
+        size_t start = reserveChildren(index, items.size());
+        for (size_t i = items.size(); i-- > 0;) {
+            const Node* item = items.begin()[i];
+            if (item) pending.push_back({ item, start + i });
+        }
+    }
+
+    // Children are laid out when their parent is visited, before any of them
+    // is, which keeps childStart in node order.
+    size_t reserveChildren(NodeIndex index, size_t count) {
+        size_t start = ast.children.size();
+        ast.childStart[index] = static_cast<uint32_t>(start);
+        ast.children.resize(start + count, NO_NODE);
+        return start;
+    }
+
+public:
+    explicit Flattener(FlatAst& target) : ast(target) {}
+
+    // Adds the tree under 'root'; returns the root's index.
+    NodeIndex add(const Node* root) {
+        if (!root) return NO_NODE;
+        NodeIndex rootIndex = static_cast<NodeIndex>(ast.kinds.size());
+        pending.push_back({ root, NO_SLOT });
+        while (!pending.empty()) {
+            Pending next = pending.back();
+            pending.pop_back();
+            NodeIndex index = addNode(next.node);
+            if (next.slot != NO_SLOT) ast.children[next.slot] = index;
+        }
+        return rootIndex;
+    }
+
+    // Adds one node and queues its children
+    NodeIndex addNode(const Node* node) {
+        NodeIndex index = static_cast<NodeIndex>(ast.kinds.size());
+        ast.kinds.push_back(node->getKind());
+        ast.lines.push_back(node->line);
+        ast.columns.push_back(node->column);
+        ast.payloads.push_back(0);
+        ast.childStart.push_back(static_cast<uint32_t>(ast.children.size()));
+        const ExprNode* expr = dyn_cast<ExprNode>(node);
+        ast.types.push_back(static_cast<uint8_t>(expr ? expr->determinedType : EntryTypeCategory::UNKNOWN_TYPE));
+        ast.offsets.push_back(0);
+
+        switch (node->getKind()) {
+        case NodeKind::IDENT:
+            ast.payloads[index] = cast<IdentNode>(node)->id;
+            break;
+        case NodeKind::INT_NUM:
+            ast.payloads[index] = static_cast<uint64_t>(cast<IntNumNode>(node)->value);
+            break;
+        case NodeKind::REAL_NUM: {
+            double value = cast<RealNumNode>(node)->value;
+            std::memcpy(&ast.payloads[index], &value, sizeof value);
+            break;
+        }
+        case NodeKind::BOOLEAN_LITERAL:
+            ast.payloads[index] = cast<BooleanLiteralNode>(node)->value ? 1 : 0;
+            break;
+        case NodeKind::STRING_LITERAL: {
+            std::string_view text = cast<StringLiteralNode>(node)->value;
+            ast.payloads[index] = (static_cast<uint64_t>(ast.strings.size()) << 32) | text.size();
+            ast.strings.append(text.data(), text.size());
+            break;
+        }
+        case NodeKind::VARIABLE: {
+            const VariableNode* n = cast<VariableNode>(node);
+            ast.offsets[index] = n->offset;
+            ast.payloads[index] = packBinding(n->kind, n->scope);
+            addChildren(index, { n->identifier, n->index });
+            break;
+        }
+        case NodeKind::ID_EXPR: {
+            const IdExprNode* n = cast<IdExprNode>(node);
+            ast.offsets[index] = n->offset;
+            ast.payloads[index] = packBinding(n->kind, n->scope);
+            addChildren(index, { n->ident });
+            break;
+        }
+        case NodeKind::FUNCTION_CALL: {
+            const FunctionCallExprNode* n = cast<FunctionCallExprNode>(node);
+            ast.payloads[index] = n->resolved_entry ? n->resolved_entry->id + 1ull : 0;
+            addChildren(index, { n->funcName, n->arguments });
+            break;
+        }
+        case NodeKind::BINARY_OP: {
+            const BinaryOpNode* n = cast<BinaryOpNode>(node);
+            ast.payloads[index] = static_cast<uint64_t>(n->op);
+            addChildren(index, { n->left, n->right });
+            break;
+        }
+        case NodeKind::UNARY_OP: {
+            const UnaryOpNode* n = cast<UnaryOpNode>(node);
+            ast.payloads[index] = static_cast<uint64_t>(n->op);
+            addChildren(index, { n->expression });
+            break;
+        }
+        case NodeKind::VAR_DECL: {
+            const VarDecl* n = cast<VarDecl>(node);
+            addChildren(index, { n->identifiers, n->type });
+            break;
+        }
+        case NodeKind::COMPOUND_STATEMENT:
+            addChildren(index, { cast<CompoundStatementNode>(node)->stmts });
+            break;
+        case NodeKind::ASSIGN_STATEMENT: {
+            const AssignStatementNode* n = cast<AssignStatementNode>(node);
+            addChildren(index, { n->variable, n->expression });
+            break;
+        }
+        case NodeKind::IF_STATEMENT: {
+            const IfStatementNode* n = cast<IfStatementNode>(node);
+            addChildren(index, { n->condition, n->thenStatement, n->elseStatement });
+            break;
+        }
+        case NodeKind::WHILE_STATEMENT: {
+            const WhileStatementNode* n = cast<WhileStatementNode>(node);
+            addChildren(index, { n->condition, n->body });
+            break;
+        }
+        case NodeKind::PROCEDURE_CALL: {
+            const ProcedureCallStatementNode* n = cast<ProcedureCallStatementNode>(node);
+            ast.payloads[index] = n->resolved_entry ? n->resolved_entry->id + 1ull : 0;
+            addChildren(index, { n->procName, n->arguments });
+            break;
+        }
+        case NodeKind::RETURN_STATEMENT:
+            addChildren(index, { cast<ReturnStatementNode>(node)->returnValue });
+            break;
+        case NodeKind::STANDARD_TYPE:
+            ast.payloads[index] = static_cast<uint64_t>(cast<StandardTypeNode>(node)->category);
+            break;
+        case NodeKind::ARRAY_TYPE: {
+            const ArrayTypeNode* n = cast<ArrayTypeNode>(node);
+            addChildren(index, { n->startIndex, n->endIndex, n->elementType });
+            break;
+        }
+        case NodeKind::FUNCTION_HEAD: {
+            const FunctionHeadNode* n = cast<FunctionHeadNode>(node);
+            addChildren(index, { n->name, n->arguments, n->returnType });
+            break;
+        }
+        case NodeKind::PROCEDURE_HEAD: {
+            const ProcedureHeadNode* n = cast<ProcedureHeadNode>(node);
+            addChildren(index, { n->name, n->arguments });
+            break;
+        }
+        case NodeKind::IDENTIFIER_LIST:
+            addList(index, cast<IdentifierList>(node)->identifiers);
+            break;
+        case NodeKind::DECLARATIONS:
+            addList(index, cast<Declarations>(node)->var_decl_items);
+            break;
+        case NodeKind::EXPRESSION_LIST:
+            addList(index, cast<ExpressionList>(node)->expressions);
+            break;
+        case NodeKind::PARAMETER_DECLARATION: {
+            const ParameterDeclaration* n = cast<ParameterDeclaration>(node);
+            addChildren(index, { n->ids, n->type });
+            break;
+        }
+        case NodeKind::PARAMETER_LIST:
+            addList(index, cast<ParameterList>(node)->paramDeclarations);
+            break;
+        case NodeKind::ARGUMENTS:
+            addChildren(index, { cast<ArgumentsNode>(node)->params });
+            break;
+        case NodeKind::STATEMENT_LIST:
+            addList(index, cast<StatementList>(node)->statements);
+            break;
+        case NodeKind::SUBPROGRAM_DECLARATION: {
+            const SubprogramDeclaration* n = cast<SubprogramDeclaration>(node);
+            addChildren(index, { n->head, n->local_declarations, n->body });
+            break;
+        }
+        case NodeKind::SUBPROGRAM_DECLARATIONS:
+            addList(index, cast<SubprogramDeclarations>(node)->subprograms);
+            break;
+        case NodeKind::PROGRAM: {
+            const ProgramNode* n = cast<ProgramNode>(node);
+            addChildren(index, { n->progName, n->decls, n->subprogs, n->mainCompoundStmt });
+            break;
+        }
+        }
+        return index;
+    }
+};
+
+// --- Rebuilding ---
+
+// Builds the nodes from the last index to the first. Numbering is pre-order,
+// so every child's index is above its parent's and the children are already
+// built when their parent's constructor needs them; nothing recurses.
+class Rebuilder {
+private:
+    const FlatAst& ast;
+    Arena& arena;
+    const StringInterner& names;
+    SymbolTable* symbols;
+    std::vector<Node*> built;
+
+    SymbolEntry* resolve(NodeIndex index) {
+        SymbolId key;
+        if (!symbols || !ast.resolvedSymbol(index, key)) return nullptr;
+        return symbols->lookupSymbol(key);
+    }
+
+    template <typename T>
+    T* child(NodeIndex node, size_t i) {
+        NodeIndex index = ast.child(node, i);
+        if (index == NO_NODE) return nullptr;
+        assert(index > node && built[index]);
+        return cast<T>(built[index]);
+    }
+
+public:
+    Rebuilder(const FlatAst& a, Arena& ar, const StringInterner& n, SymbolTable* s)
+        : ast(a), arena(ar), names(n), symbols(s), built(a.size(), nullptr) {}
+
+    // Builds every node; returns the root.
+    Node* buildAll() {
+        for (size_t index = ast.size(); index-- > 0;) {
+            built[index] = build(static_cast<NodeIndex>(index));
+        }
+        return built[ast.root()];
+    }
+
+    // Builds one node from its already built children
+    Node* build(NodeIndex index) {
+        int l = ast.lines[index];
+        int c = ast.columns[index];
+        Node* node = nullptr;
+
+        switch (ast.kind(index)) {
+        case NodeKind::IDENT: {
+            SymbolId id = ast.symbol(index);
+            node = new (arena) IdentNode(id, names.name(id), l, c);
+            break;
+        }
+        case NodeKind::INT_NUM:
+            node = new (arena) IntNumNode(ast.intValue(index), l, c);
+            break;
+        case NodeKind::REAL_NUM:
+            node = new (arena) RealNumNode(ast.realValue(index), l, c);
+            break;
+        case NodeKind::BOOLEAN_LITERAL:
+            node = new (arena) BooleanLiteralNode(ast.boolValue(index), l, c);
+            break;
+        case NodeKind::STRING_LITERAL:
+            node = new (arena) StringLiteralNode(arena.copy(ast.stringValue(index)), l, c);
+            break;
+        case NodeKind::VARIABLE: {
+            VariableNode* n = new (arena) VariableNode(child<IdentNode>(index, 0), child<ExprNode>(index, 1), l, c);
+            n->offset = ast.offsets[index];
+            n->kind = ast.symbolKind(index);
+            n->scope = ast.symbolScope(index);
+            node = n;
+            break;
+        }
+        case NodeKind::ID_EXPR: {
+            IdExprNode* n = new (arena) IdExprNode(child<IdentNode>(index, 0), l, c);
+            n->offset = ast.offsets[index];
+            n->kind = ast.symbolKind(index);
+            n->scope = ast.symbolScope(index);
+            node = n;
+            break;
+        }
+        case NodeKind::FUNCTION_CALL: {
+            FunctionCallExprNode* n = new (arena) FunctionCallExprNode(child<IdentNode>(index, 0), child<ExpressionList>(index, 1), l, c);
+            n->resolved_entry = resolve(index);
+            node = n;
+            break;
+        }
+        case NodeKind::BINARY_OP:
+            node = new (arena) BinaryOpNode(child<ExprNode>(index, 0), ast.binaryOperator(index), child<ExprNode>(index, 1), l, c);
+            break;
+        case NodeKind::UNARY_OP:
+            node = new (arena) UnaryOpNode(ast.unaryOperator(index), child<ExprNode>(index, 0), l, c);
+            break;
+        case NodeKind::VAR_DECL:
+            node = new (arena) VarDecl(child<IdentifierList>(index, 0), child<TypeNode>(index, 1), l, c);
+            break;
+        case NodeKind::COMPOUND_STATEMENT:
+            node = new (arena) CompoundStatementNode(child<StatementList>(index, 0), l, c);
+            break;
+        case NodeKind::ASSIGN_STATEMENT:
+            node = new (arena) AssignStatementNode(child<VariableNode>(index, 0), child<ExprNode>(index, 1), l, c);
+            break;
+        case NodeKind::IF_STATEMENT:
+            node = new (arena) IfStatementNode(child<ExprNode>(index, 0), child<StatementNode>(index, 1), child<StatementNode>(index, 2), l, c);
+            break;
+        case NodeKind::WHILE_STATEMENT:
+            node = new (arena) WhileStatementNode(child<ExprNode>(index, 0), child<StatementNode>(index, 1), l, c);
+            break;
+        case NodeKind::PROCEDURE_CALL: {
+            ProcedureCallStatementNode* n = new (arena) ProcedureCallStatementNode(child<IdentNode>(index, 0), child<ExpressionList>(index, 1), l, c);
+            n->resolved_entry = resolve(index);
+            node = n;
+            break;
+        }
+        case NodeKind::RETURN_STATEMENT:
+            node = new (arena) ReturnStatementNode(child<ExprNode>(index, 0), l, c);
+            break;
+        case NodeKind::STANDARD_TYPE:
+            node = new (arena) StandardTypeNode(ast.typeCategory(index), l, c);
+            break;
+        case NodeKind::ARRAY_TYPE:
+            node = new (arena) ArrayTypeNode(child<IntNumNode>(index, 0), child<IntNumNode>(index, 1), child<StandardTypeNode>(index, 2), l, c);
+            break;
+        case NodeKind::FUNCTION_HEAD:
+            node = new (arena) FunctionHeadNode(child<IdentNode>(index, 0), child<ArgumentsNode>(index, 1), child<StandardTypeNode>(index, 2), l, c);
+            break;
+        case NodeKind::PROCEDURE_HEAD:
+            node = new (arena) ProcedureHeadNode(child<IdentNode>(index, 0), child<ArgumentsNode>(index, 1), l, c);
+            break;
+        case NodeKind::IDENTIFIER_LIST: {
+            IdentifierList* n = new (arena) IdentifierList(arena, nullptr, l, c);
+            for (size_t i = 0; i < ast.childCount(index); i++) n->addIdentifier(child<IdentNode>(index, i));
+            node = n;
+            break;
+        }
+        case NodeKind::DECLARATIONS: {
+            Declarations* n = new (arena) Declarations(arena, l, c);
+            for (size_t i = 0; i < ast.childCount(index); i++) n->addVarDecl(child<VarDecl>(index, i));
+            node = n;
+            break;
+        }
+        case NodeKind::EXPRESSION_LIST: {
+            ExpressionList* n = new (arena) ExpressionList(arena, l, c);
+            for (size_t i = 0; i < ast.childCount(index); i++) n->addExpression(child<ExprNode>(index, i));
+            node = n;
+            break;
+        }
+        case NodeKind::PARAMETER_DECLARATION:
+            node = new (arena) ParameterDeclaration(child<IdentifierList>(index, 0), child<TypeNode>(index, 1), l, c);
+            break;
+        case NodeKind::PARAMETER_LIST: {
+            ParameterList* n = new (arena) ParameterList(arena, nullptr, l, c);
+            for (size_t i = 0; i < ast.childCount(index); i++) n->addParameterDeclarationGroup(child<ParameterDeclaration>(index, i));
+            node = n;
+            break;
+        }
+        case NodeKind::ARGUMENTS:
+            node = new (arena) ArgumentsNode(child<ParameterList>(index, 0), l, c);
+            break;
+        case NodeKind::STATEMENT_LIST: {
+            StatementList* n = new (arena) StatementList(arena, l, c);
+            for (size_t i = 0; i < ast.childCount(index); i++) n->addStatement(child<StatementNode>(index, i));
+            node = n;
+            break;
+        }
+        case NodeKind::SUBPROGRAM_DECLARATION:
+            node = new (arena) SubprogramDeclaration(child<SubprogramHead>(index, 0), child<Declarations>(index, 1), child<CompoundStatementNode>(index, 2), l, c);
+            break;
+        case NodeKind::SUBPROGRAM_DECLARATIONS: {
+            SubprogramDeclarations* n = new (arena) SubprogramDeclarations(arena, l, c);
+            for (size_t i = 0; i < ast.childCount(index); i++) n->addSubprogramDeclaration(child<SubprogramDeclaration>(index, i));
+            node = n;
+            break;
+        }
+        case NodeKind::PROGRAM:
+            node = new (arena) ProgramNode(child<IdentNode>(index, 0), child<Declarations>(index, 1),
+                child<SubprogramDeclarations>(index, 2), child<CompoundStatementNode>(index, 3), l, c);
+            break;
+        }
+
+        if (ExprNode* expr = dyn_cast<ExprNode>(node)) expr->determinedType = ast.type(index);
+        return node;
+    }
+};
+
+// --- Validation ---
+
+// Node kinds a child slot takes. The node classes with subclasses have their
+// kinds next to each other, so each slot is a range.
+struct Slot {
+    NodeKind first;
+    NodeKind last;
+    bool takes(NodeKind kind) const { return kind >= first && kind <= last; }
+};
+
+constexpr Slot only(NodeKind kind) { return { kind, kind }; }
+constexpr Slot ANY_EXPR = { NodeKind::IDENT, NodeKind::UNARY_OP };
+constexpr Slot ANY_STATEMENT = { NodeKind::VAR_DECL, NodeKind::RETURN_STATEMENT };
+constexpr Slot ANY_TYPE = { NodeKind::STANDARD_TYPE, NodeKind::ARRAY_TYPE };
+constexpr Slot ANY_HEAD = { NodeKind::FUNCTION_HEAD, NodeKind::PROCEDURE_HEAD };
+
+// The children a kind has, as Rebuilder::build() reads them: 'count' fixed
+// slots, or for a list any number of children in slots[0].
+struct Shape {
+    bool isList;
+    size_t count;
+    Slot slots[4];
+};
+
+Shape shapeOf(NodeKind kind) {
+    switch (kind) {
+    case NodeKind::VARIABLE: return { false, 2, { only(NodeKind::IDENT), ANY_EXPR } };
+    case NodeKind::ID_EXPR: return { false, 1, { only(NodeKind::IDENT) } };
+    case NodeKind::FUNCTION_CALL:
+    case NodeKind::PROCEDURE_CALL: return { false, 2, { only(NodeKind::IDENT), only(NodeKind::EXPRESSION_LIST) } };
+    case NodeKind::BINARY_OP: return { false, 2, { ANY_EXPR, ANY_EXPR } };
+    case NodeKind::UNARY_OP:
+    case NodeKind::RETURN_STATEMENT: return { false, 1, { ANY_EXPR } };
+    case NodeKind::VAR_DECL:
+    case NodeKind::PARAMETER_DECLARATION: return { false, 2, { only(NodeKind::IDENTIFIER_LIST), ANY_TYPE } };
+    case NodeKind::COMPOUND_STATEMENT: return { false, 1, { only(NodeKind::STATEMENT_LIST) } };
+    case NodeKind::ASSIGN_STATEMENT: return { false, 2, { only(NodeKind::VARIABLE), ANY_EXPR } };
+    case NodeKind::IF_STATEMENT: return { false, 3, { ANY_EXPR, ANY_STATEMENT, ANY_STATEMENT } };
+    case NodeKind::WHILE_STATEMENT: return { false, 2, { ANY_EXPR, ANY_STATEMENT } };
+    case NodeKind::ARRAY_TYPE:
+        return { false, 3, { only(NodeKind::INT_NUM), only(NodeKind::INT_NUM), only(NodeKind::STANDARD_TYPE) } };
+    case NodeKind::FUNCTION_HEAD:
+        return { false, 3, { only(NodeKind::IDENT), only(NodeKind::ARGUMENTS), only(NodeKind::STANDARD_TYPE) } };
+    case NodeKind::PROCEDURE_HEAD: return { false, 2, { only(NodeKind::IDENT), only(NodeKind::ARGUMENTS) } };
+    case NodeKind::ARGUMENTS: return { false, 1, { only(NodeKind::PARAMETER_LIST) } };
+    case NodeKind::SUBPROGRAM_DECLARATION:
+        return { false, 3, { ANY_HEAD, only(NodeKind::DECLARATIONS), only(NodeKind::COMPOUND_STATEMENT) } };
+    case NodeKind::PROGRAM:
+        return { false, 4, { only(NodeKind::IDENT), only(NodeKind::DECLARATIONS),
+            only(NodeKind::SUBPROGRAM_DECLARATIONS), only(NodeKind::COMPOUND_STATEMENT) } };
+    case NodeKind::IDENTIFIER_LIST: return { true, 0, { only(NodeKind::IDENT) } };
+    case NodeKind::DECLARATIONS: return { true, 0, { only(NodeKind::VAR_DECL) } };
+    case NodeKind::EXPRESSION_LIST: return { true, 0, { ANY_EXPR } };
+    case NodeKind::PARAMETER_LIST: return { true, 0, { only(NodeKind::PARAMETER_DECLARATION) } };
+    case NodeKind::STATEMENT_LIST: return { true, 0, { ANY_STATEMENT } };
+    case NodeKind::SUBPROGRAM_DECLARATIONS: return { true, 0, { only(NodeKind::SUBPROGRAM_DECLARATION) } };
+    default: return { false, 0, {} }; // the leaves
+    }
+}
+
+// The payload of 'index', which has a valid kind, is one build() can use.
+bool validPayload(const FlatAst& ast, NodeIndex index, size_t nameCount) {
+    uint64_t payload = ast.payloads[index];
+    switch (ast.kind(index)) {
+    case NodeKind::IDENT:
+        return payload < nameCount;
+    case NodeKind::STRING_LITERAL:
+        return (payload >> 32) + (payload & 0xFFFFFFFFu) <= ast.strings.size();
+    case NodeKind::VARIABLE:
+    case NodeKind::ID_EXPR:
+        return (payload & 0xFF) <= static_cast<uint64_t>(SymbolKind::PROGRAM_NAME) &&
+            (payload >> 8) <= static_cast<uint64_t>(SymbolScope::LOCAL);
+    case NodeKind::FUNCTION_CALL:
+    case NodeKind::PROCEDURE_CALL:
+        return payload <= nameCount; // 0, or a SymbolId plus one
+    case NodeKind::BINARY_OP:
+        return payload < BINARY_OPERATOR_COUNT;
+    case NodeKind::UNARY_OP:
+        return payload <= static_cast<uint64_t>(UnaryOperator::NOT);
+    case NodeKind::STANDARD_TYPE:
+        return payload <= StandardTypeNode::TYPE_BOOLEAN;
+    default:
+        return true;
+    }
+}
+
+} // namespace
+
+bool FlatAst::validate(size_t nameCount) const {
+    size_t count = kinds.size();
+    if (count == 0 || count >= NO_NODE || lines.size() != count || columns.size() != count ||
+        payloads.size() != count || types.size() != count || offsets.size() != count ||
+        childStart.size() != count + 1 || childStart[count] != children.size() || kind(root()) != NodeKind::PROGRAM) {
+        return false;
+    }
+
+    std::vector<bool> hasParent(count, false);
+    for (NodeIndex index = 0; index < count; index++) {
+        if (kinds[index] > NodeKind::PROGRAM || types[index] > static_cast<uint8_t>(EntryTypeCategory::ARRAY) ||
+            childStart[index] > childStart[index + 1] || childStart[index + 1] > children.size() || !validPayload(*this, index, nameCount)) {
+            return false;
+        }
+        Shape shape = shapeOf(kind(index));
+        size_t children = childCount(index);
+        if (!shape.isList && children != shape.count) return false;
+        for (size_t i = 0; i < children; i++) {
+            NodeIndex node = child(index, i);
+            if (node == NO_NODE) continue;
+            // Numbered after the parent and nobody else's child: a tree, and
+            // build() has made the child by the time the parent needs it.
+            if (node <= index || node >= count || hasParent[node]) return false;
+            if (!shape.slots[shape.isList ? 0 : i].takes(kind(node))) return false;
+            hasParent[node] = true;
+        }
+    }
+    return true;
+}
+
+FlatAst FlatAst::fromTree(const ProgramNode& root) {
+    FlatAst ast;
+    Flattener(ast).add(&root);
+    ast.childStart.push_back(static_cast<uint32_t>(ast.children.size()));
+    return ast;
+}
+
+ProgramNode* FlatAst::toTree(Arena& arena, const StringInterner& names, SymbolTable* symbols) const {
+    if (empty()) return nullptr;
+    return cast<ProgramNode>(Rebuilder(*this, arena, names, symbols).buildAll());
+}
+
+double FlatAst::realValue(NodeIndex node) const {
+    double value;
+    std::memcpy(&value, &payloads[node], sizeof value);
+    return value;
+}
+
+bool FlatAst::resolvedSymbol(NodeIndex node, SymbolId& key) const {
+    if (payloads[node] == 0) return false;
+    key = static_cast<SymbolId>(payloads[node] - 1);
+    return true;
+}
+
+std::string_view FlatAst::stringValue(NodeIndex node) const {
+    uint64_t packed = payloads[node];
+    return std::string_view(strings.data() + (packed >> 32), static_cast<size_t>(packed & 0xFFFFFFFFu));
+}
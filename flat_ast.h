@@ -0,0 +1,109 @@
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "ast.h"
+#include "interner.h"
+#include "symbol_table.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Index of a node in a FlatAst
+using NodeIndex = uint32_t;
+const NodeIndex NO_NODE = 0xFFFFFFFFu;
+
+// Serialized form of a whole program, which is what the AST cache stores: the
+// nodes live in parallel arrays indexed by 32-bit NodeIndex, with children as
+// index ranges in one shared pool. Nodes are numbered in pre-order, so the
+// root is 0 and the child ranges appear in 'children' in node order. Being a
+// handful of arrays rather than a graph, it can be written out and read back
+// as it is. Nothing compiles from it directly: the parser builds the pointer
+// tree, and a loaded FlatAst is turned back into one with toTree().
+//
+// Children come in a fixed order per kind, with NO_NODE for a missing optional
+// child (an else branch, an array index, ...):
+//   PROGRAM                name, declarations, subprograms, body
+//   VAR_DECL, PARAMETER_DECLARATION     identifiers, type
+//   ARRAY_TYPE             start, end, element type
+//   FUNCTION_HEAD          name, arguments, return type
+//   PROCEDURE_HEAD         name, arguments
+//   ARGUMENTS              parameter list
+//   SUBPROGRAM_DECLARATION head, declarations, body
+//   COMPOUND_STATEMENT     statement list
+//   ASSIGN_STATEMENT       variable, expression
+//   IF_STATEMENT           condition, then, else
+//   WHILE_STATEMENT        condition, body
+//   PROCEDURE_CALL, FUNCTION_CALL       name, argument list
+//   RETURN_STATEMENT       value
+//   VARIABLE               identifier, index
+//   ID_EXPR                identifier
+//   BINARY_OP              left, right
+//   UNARY_OP               operand
+//   the *_LIST, DECLARATIONS and SUBPROGRAM_DECLARATIONS kinds: their elements
+// Leaf values, operators and the analyzer's bindings are in 'payloads'; see
+// the accessors.
+class FlatAst {
+public:
+    // --- Per-node columns ---
+    std::vector<NodeKind> kinds;
+    std::vector<int32_t> lines;
+    std::vector<int32_t> columns;
+    std::vector<uint64_t> payloads;
+    // Children of node i are children[childStart[i] .. childStart[i + 1])
+    std::vector<uint32_t> childStart;
+
+    // --- Side tables for what the semantic analyzer worked out ---
+    std::vector<uint8_t> types;             // ExprNode::determinedType, as a byte
+    std::vector<int32_t> offsets;           // VARIABLE / ID_EXPR offset
+
+    std::vector<NodeIndex> children;
+    std::string strings; // string literal text, referenced from payloads
+
+    // Flattens a (possibly analyzed) tree.
+    static FlatAst fromTree(const ProgramNode& root);
+    // Checks that the arrays hold a tree toTree() can rebuild: matching
+    // column sizes, child ranges inside 'children', every child numbered after
+    // its parent and of a kind its slot takes, and payloads in range (string
+    // text inside 'strings', enums valid, SymbolIds below 'nameCount'). A
+    // FlatAst read from outside must pass this before toTree() is called.
+    bool validate(size_t nameCount) const;
+    // Rebuilds the pointer tree in 'arena' for SemanticAnalyzer and
+    // CodeGenerator. Identifier names come from 'names', which must be the
+    // interner the tree was built with. Given the analyzer's global scope in
+    // 'symbols', calls get their resolved_entry back, so an analyzed tree can
+    // go straight to the code generator.
+    ProgramNode* toTree(Arena& arena, const StringInterner& names, SymbolTable* symbols = nullptr) const;
+
+    size_t size() const { return kinds.size(); }
+    bool empty() const { return kinds.empty(); }
+    NodeIndex root() const { return 0; }
+
+    NodeKind kind(NodeIndex node) const { return kinds[node]; }
+    size_t childCount(NodeIndex node) const { return childStart[node + 1] - childStart[node]; }
+    NodeIndex child(NodeIndex node, size_t i) const { return children[childStart[node] + i]; }
+
+    EntryTypeCategory type(NodeIndex node) const { return static_cast<EntryTypeCategory>(types[node]); }
+
+    // --- Leaf values ---
+    SymbolId symbol(NodeIndex node) const { return static_cast<SymbolId>(payloads[node]); }                 // IDENT
+    int64_t intValue(NodeIndex node) const { return static_cast<int64_t>(payloads[node]); }               // INT_NUM
+    double realValue(NodeIndex node) const;                                                                 // REAL_NUM
+    bool boolValue(NodeIndex node) const { return payloads[node] != 0; }                                   // BOOLEAN_LITERAL
+    std::string_view stringValue(NodeIndex node) const;                                                     // STRING_LITERAL
+    BinaryOperator binaryOperator(NodeIndex node) const { return static_cast<BinaryOperator>(payloads[node]); }
+    UnaryOperator unaryOperator(NodeIndex node) const { return static_cast<UnaryOperator>(payloads[node]); }
+    StandardTypeNode::TypeCategory typeCategory(NodeIndex node) const {                                     // STANDARD_TYPE
+        return static_cast<StandardTypeNode::TypeCategory>(payloads[node]);
+    }
+
+    // --- Analyzer bindings ---
+    // VARIABLE / ID_EXPR: what the identifier was bound to
+    SymbolKind symbolKind(NodeIndex node) const { return static_cast<SymbolKind>(payloads[node] & 0xFF); }
+    SymbolScope symbolScope(NodeIndex node) const { return static_cast<SymbolScope>(payloads[node] >> 8 & 0xFF); }
+    // PROCEDURE_CALL / FUNCTION_CALL: symbol table key of the overload called;
+    // false if the call was never resolved.
+    bool resolvedSymbol(NodeIndex node, SymbolId& key) const;
+};
+
+#endif // FLAT_AST_H
@@ -0,0 +1,26 @@
+#include "interner.h"
+
+StringInterner::StringInterner() {
+    // Same order as BuiltinSymbol
+    intern("read");
+    intern("readln");
+    intern("write");
+    intern("writeln");
+}
+
+SymbolId StringInterner::intern(std::string_view text) {
+    auto found = ids.find(text);
+    if (found != ids.end()) return found->second;
+
+    SymbolId id = static_cast<SymbolId>(names.size());
+    names.emplace_back(text);
+    ids.emplace(std::string_view(names.back()), id);
+    return id;
+}
+
+bool StringInterner::find(std::string_view text, SymbolId& id) const {
+    auto found = ids.find(text);
+    if (found == ids.end()) return false;
+    id = found->second;
+    return true;
+}
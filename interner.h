@@ -0,0 +1,51 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Compact handle for an interned identifier: equal names have equal ids.
+using SymbolId = uint32_t;
+
+// Ids of the built-in procedures, interned by every StringInterner up front
+// so the analyzers can recognise them with an integer compare.
+enum BuiltinSymbol : SymbolId {
+    SYM_READ,
+    SYM_READLN,
+    SYM_WRITE,
+    SYM_WRITELN
+};
+
+// Per-compilation pool of identifier spellings. The lexer interns every
+// identifier once; IdentNodes and the symbol table then work with SymbolIds,
+// and the text is stored exactly once.
+class StringInterner {
+private:
+    std::deque<std::string> names; // deque: growing never moves the strings the map's keys view
+    std::unordered_map<std::string_view, SymbolId> ids;
+
+public:
+    StringInterner();
+
+    StringInterner(const StringInterner&) = delete;
+    StringInterner& operator=(const StringInterner&) = delete;
+
+    SymbolId intern(std::string_view text);
+    // Looks 'text' up without adding it; false if it was never interned.
+    bool find(std::string_view text, SymbolId& id) const;
+
+    const std::string& name(SymbolId id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+};
+
+// What the lexer hands the parser for an IDENT token
+struct IdentToken {
+    SymbolId id;
+    int line;
+    int column;
+};
+
+#endif // INTERNER_H
@@ -0,0 +1,18 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include "ast.h"
+#include "parser.h"
+#include "source_buffer.h"
+
+struct CompilationContext;
+
+// Scans 'source' in place into ctx.tokens and interns identifiers into
+// ctx.names. STRING_LITERAL tokens point into 'source', so it has to outlive
+// ctx.tokens.
+void tokenize(SourceBuffer& source, CompilationContext& ctx);
+
+// A helper function to help with generating the tokens.txt file.
+const char* token_to_string(int token, const YYSTYPE& lval);
+
+#endif // LEXER_H
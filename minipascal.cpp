@@ -0,0 +1,52 @@
+#include "minipascal.h"
+#include "compiler.h"
+#include <algorithm>
+#include <sstream>
+
+namespace minipascal {
+
+Result compile(std::string_view source, const Options& options) {
+    std::ostream quiet(nullptr);
+    std::ostringstream diagnostics;
+
+    CompilationContext ctx;
+    ctx.input_filename = options.name;
+    ctx.base_name = get_base_filename(options.name);
+    ctx.emit = options.keep_artifacts ? EMIT_ALL : EMIT_ASM;
+    ctx.scanner = options.fast_scanner ? SCANNER_FAST : SCANNER_FLEX;
+    ctx.out = &quiet;
+    ctx.err = &diagnostics;
+
+    TimeReport report;
+    if (options.time_phases) ctx.time_report = &report;
+
+    MemoryArtifactStore artifacts(ctx.output_dir, ctx.base_name);
+    Result result;
+    result.status = compileSource(ctx, source, artifacts);
+    std::map<std::string, std::string> contents = artifacts.release();
+
+    // With the semantic log emitted, the errors went there instead of to ctx.err.
+    auto semantic_log = contents.find(".semantic_analysis.log");
+    if (result.status == CompileStatus::SEMANTIC_ERROR && semantic_log != contents.end()) {
+        diagnostics << semantic_log->second;
+    }
+    result.diagnostics = diagnostics.str();
+
+    auto assembly = contents.find(".assembly.vm");
+    if (assembly != contents.end()) {
+        result.assembly = std::move(assembly->second);
+        contents.erase(assembly);
+    }
+
+    result.stats.source_bytes = source.size();
+    result.stats.tokens = ctx.tokens.size();
+    result.stats.assembly_lines = std::count(result.assembly.begin(), result.assembly.end(), '\n');
+    if (options.time_phases) result.stats.phases = report.ranPhases();
+
+    if (options.keep_artifacts) {
+        result.artifacts = std::move(contents);
+    }
+    return result;
+}
+
+} // namespace minipascal
@@ -0,0 +1,52 @@
+#ifndef MINIPASCAL_H
+#define MINIPASCAL_H
+
+// Embeddable MiniPascal compiler: source text in, VM assembly and diagnostics
+// out. Nothing is read from or written to disk, and every call is independent,
+// so compile() may be called from several threads at once.
+
+#include "compile_status.h"
+#include "time_report.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace minipascal {
+
+struct Options {
+    // Name of the program in diagnostics and artifact keys; no file is opened.
+    std::string name = "input.pas";
+    // Also return the token list, AST dump and semantic log in Result::artifacts.
+    bool keep_artifacts = false;
+    // Measure every phase into Stats::phases.
+    bool time_phases = false;
+    // Scan with the hand-written scanner instead of the flex one (--scanner=fast).
+    bool fast_scanner = false;
+};
+
+struct Stats {
+    size_t source_bytes = 0;
+    size_t tokens = 0;
+    size_t assembly_lines = 0;
+    std::vector<PhaseStats> phases; // only with Options::time_phases
+};
+
+struct Result {
+    CompileStatus status = CompileStatus::SUCCESS;
+    std::string assembly;     // empty unless status == SUCCESS
+    std::string diagnostics;  // every error and warning, including semantic errors
+    Stats stats;
+    // Keyed by suffix (".tokens.txt", ".ast.txt", ".semantic_analysis.log"),
+    // filled only when Options::keep_artifacts is set.
+    std::map<std::string, std::string> artifacts;
+
+    bool ok() const { return status == CompileStatus::SUCCESS; }
+};
+
+Result compile(std::string_view source, const Options& options = Options());
+
+} // namespace minipascal
+
+#endif // MINIPASCAL_H
@@ -4,19 +4,47 @@
 #include <string>
 #include <vector>
 #include <list>
+#include "compilation_context.h"
 
-extern int yylex();
-extern int yyerror(const char*);
 extern int yydebug;
 
-extern int lin;
-extern int col;
+// Nested parentheses and IF / ELSE chains each hold a few parser stack
+// entries per level. The stack starts small and is grown on the heap as
+// needed; Bison's default cap of 10000 entries would reject sources nested
+// more than a few thousand deep, which the rest of the compiler handles.
+#define YYMAXDEPTH 1000000
+%}
 
-// An external reference to the global error flag
-extern bool compilation_has_error;
+%code requires {
+    #include "source_buffer.h"
+    #include "interner.h"
+    #include <cstdint>
+    struct CompilationContext;
+
+    // What the lexer hands the parser for NUM / REAL_LITERAL tokens. The value
+    // travels in the semantic value itself, so scanning a number allocates nothing.
+    struct IntToken {
+        int64_t value;
+        int line;
+        int column;
+    };
+    struct RealToken {
+        double value;
+        int line;
+        int column;
+    };
+}
 
-ProgramNode *root_ast_node;
-%}
+%code provides {
+    int yylex(YYSTYPE* lval, CompilationContext* ctx);
+    int yyerror(CompilationContext* ctx, const char* s);
+}
+
+%define api.pure full
+// Messages name the unexpected token and what would have fit instead.
+%define parse.error verbose
+%parse-param { CompilationContext* ctx }
+%lex-param { CompilationContext* ctx }
 
 %union {
     Node* pNode;
@@ -46,23 +74,27 @@ ProgramNode *root_ast_node;
     BooleanLiteralNode* pBooleanLiteralNode;
     StringLiteralNode* pStringLiteralNode;
 
-    Num* rawNum;
-    RealLit* rawRealLit;
-    Ident* rawIdent;
+    IntToken int_token;
+    RealToken real_token;
 
     int token_val;
-    char* str_val;
+    IdentToken ident;
+    SourceSpan str_span;
 }
 
-%token <rawNum> NUM
-%token <rawRealLit> REAL_LITERAL
-%token <rawIdent> IDENT
-%token TRUE_KEYWORD FALSE_KEYWORD
-%token PROGRAM VAR ARRAY OF INTEGER_TYPE REAL_TYPE BOOLEAN_TYPE FUNCTION PROCEDURE
-%token BEGIN_TOKEN END_TOKEN IF THEN ELSE WHILE DO NOT_OP AND_OP OR_OP DIV_OP
-%token ASSIGN_OP EQ_OP NEQ_OP LT_OP LTE_OP GT_OP GTE_OP DOTDOT
-%token <str_val> STRING_LITERAL
-%token RETURN_KEYWORD
+// The quoted aliases are how syntax errors spell the tokens.
+%token <int_token> NUM "integer literal"
+%token <real_token> REAL_LITERAL "real literal"
+%token <ident> IDENT "identifier"
+%token TRUE_KEYWORD "TRUE" FALSE_KEYWORD "FALSE"
+%token PROGRAM "PROGRAM" VAR "VAR" ARRAY "ARRAY" OF "OF"
+%token INTEGER_TYPE "INTEGER" REAL_TYPE "REAL" BOOLEAN_TYPE "BOOLEAN"
+%token FUNCTION "FUNCTION" PROCEDURE "PROCEDURE"
+%token BEGIN_TOKEN "BEGIN" END_TOKEN "END" IF "IF" THEN "THEN" ELSE "ELSE" WHILE "WHILE" DO "DO"
+%token NOT_OP "NOT" AND_OP "AND" OR_OP "OR" DIV_OP "DIV"
+%token ASSIGN_OP ":=" EQ_OP "=" NEQ_OP "<>" LT_OP "<" LTE_OP "<=" GT_OP ">" GTE_OP ">=" DOTDOT ".."
+%token <str_span> STRING_LITERAL "string literal"
+%token RETURN_KEYWORD "RETURN"
 
 // %type declarations for original grammar structure
 %type <pProgramNode> program_rule
@@ -104,64 +136,77 @@ ProgramNode *root_ast_node;
 
 %start program_rule
 
+// --- Error recovery ---
+// A syntax error doesn't end the parse. The 'error' alternatives below drop
+// the broken statement, variable declaration, parameter list or subprogram,
+// skip ahead to the next ';', END or BEGIN, and carry on, so one run reports
+// every syntax error. What gets dropped is replaced by an empty statement or
+// left out of its list; a variable declaration with a broken type keeps its
+// names, so their uses aren't reported as undeclared. The compiler still runs
+// semantic analysis on the recovered tree, but generates no code for it.
+
 %%
 
 program_rule: PROGRAM id_node ';' declarations subprogram_declarations compound_statement '.'
-    { $$ = new ProgramNode($2, $4, $5, $6, lin, col); root_ast_node = $$; }
+    { $$ = new (ctx->arena) ProgramNode($2, $4, $5, $6, ctx->lin, ctx->col); ctx->root_ast_node = $$; }
     ;
 
 id_node: IDENT
-    { $$ = new IdentNode($1->name, $1->line, $1->column); delete $1; }
+    { $$ = new (ctx->arena) IdentNode($1.id, ctx->names.name($1.id), $1.line, $1.column); }
     ;
 
 identifier_list: id_node
-    { $$ = new IdentifierList($1, lin, col); }
+    { $$ = new (ctx->arena) IdentifierList(ctx->arena, $1, ctx->lin, ctx->col); }
     | identifier_list ',' id_node
     { $1->addIdentifier($3); $$ = $1; }
     ;
 
 declarations: /* empty */
-    { $$ = new Declarations(lin, col); }
+    { $$ = new (ctx->arena) Declarations(ctx->arena, ctx->lin, ctx->col); }
     | VAR var_declaration_list_non_empty
     { $$ = $2; }
     ;
 
 var_declaration_list_non_empty: var_declaration_item
-    { $$ = new Declarations(lin, col); $$->addVarDecl($1); }
+    { $$ = new (ctx->arena) Declarations(ctx->arena, ctx->lin, ctx->col); if ($1) $$->addVarDecl($1); }
     | var_declaration_list_non_empty var_declaration_item
-    { $1->addVarDecl($2); $$ = $1; }
+    { if ($2) $1->addVarDecl($2); $$ = $1; }
     ;
 
 var_declaration_item: identifier_list ':' type ';'
-    { $$ = new VarDecl($1, $3, lin, col); }
+    { $$ = new (ctx->arena) VarDecl($1, $3, ctx->lin, ctx->col); }
+    | identifier_list error ';' // e.g. a missing ':': the names are still declared, with no type
+    { $$ = new (ctx->arena) VarDecl($1, nullptr, ctx->lin, ctx->col); yyerrok; }
+    | error ';'
+    { $$ = nullptr; yyerrok; }
     ;
 
 type: standard_type
     { $$ = $1; }
     | ARRAY '[' int_num_node DOTDOT int_num_node ']' OF standard_type
-    { $$ = new ArrayTypeNode($3, $5, $8, lin, col); }
+    { $$ = new (ctx->arena) ArrayTypeNode($3, $5, $8, ctx->lin, ctx->col); }
     ;
 
 int_num_node: NUM
-    { $$ = new IntNumNode($1->value, $1->line, $1->column); delete $1; }
+    { $$ = new (ctx->arena) IntNumNode($1.value, $1.line, $1.column); }
     ;
 
 real_num_node: REAL_LITERAL
-    { $$ = new RealNumNode($1->value, $1->line, $1->column); delete $1; }
+    { $$ = new (ctx->arena) RealNumNode($1.value, $1.line, $1.column); }
     ;
 
 standard_type: INTEGER_TYPE
-    { $$ = new StandardTypeNode(StandardTypeNode::TYPE_INTEGER, lin, col); }
+    { $$ = new (ctx->arena) StandardTypeNode(StandardTypeNode::TYPE_INTEGER, ctx->lin, ctx->col); }
     | REAL_TYPE
-    { $$ = new StandardTypeNode(StandardTypeNode::TYPE_REAL, lin, col); }
+    { $$ = new (ctx->arena) StandardTypeNode(StandardTypeNode::TYPE_REAL, ctx->lin, ctx->col); }
     | BOOLEAN_TYPE
-    { $$ = new StandardTypeNode(StandardTypeNode::TYPE_BOOLEAN, lin, col); }
+    { $$ = new (ctx->arena) StandardTypeNode(StandardTypeNode::TYPE_BOOLEAN, ctx->lin, ctx->col); }
     ;
 
 subprogram_declarations: /* empty */
-    { $$ = new SubprogramDeclarations(lin, col); }
+    { $$ = new (ctx->arena) SubprogramDeclarations(ctx->arena, ctx->lin, ctx->col); }
     | subprogram_declarations subprogram_declaration_block
-    { $1->addSubprogramDeclaration($2); $$ = $1; }
+    { if ($2) $1->addSubprogramDeclaration($2); $$ = $1; }
     ;
 
 subprogram_declaration_block: subprogram_declaration ';'
@@ -169,37 +214,43 @@ subprogram_declaration_block: subprogram_declaration ';'
     ;
 
 subprogram_declaration: subprogram_head declarations compound_statement
-    { $$ = new SubprogramDeclaration($1, $2, $3, lin, col); }
+    { $$ = new (ctx->arena) SubprogramDeclaration($1, $2, $3, ctx->lin, ctx->col); }
+    | FUNCTION error declarations compound_statement // a broken head: resume at its VAR or BEGIN
+    { $$ = nullptr; }
+    | PROCEDURE error declarations compound_statement
+    { $$ = nullptr; }
     ;
 
 subprogram_head: FUNCTION id_node arguments ':' standard_type ';'
-    { $$ = new FunctionHeadNode($2, $3, $5, lin, col); }
+    { $$ = new (ctx->arena) FunctionHeadNode($2, $3, $5, ctx->lin, ctx->col); }
     | PROCEDURE id_node arguments ';'
-    { $$ = new ProcedureHeadNode($2, $3, lin, col); }
+    { $$ = new (ctx->arena) ProcedureHeadNode($2, $3, ctx->lin, ctx->col); }
     ;
 
 arguments: /* empty */
-    { $$ = new ArgumentsNode(lin, col); }
+    { $$ = new (ctx->arena) ArgumentsNode(ctx->lin, ctx->col); }
     | '(' parameter_list ')'
-    { $$ = new ArgumentsNode($2, lin, col); }
+    { $$ = new (ctx->arena) ArgumentsNode($2, ctx->lin, ctx->col); }
+    | '(' error ')'
+    { $$ = new (ctx->arena) ArgumentsNode(ctx->lin, ctx->col); yyerrok; }
     ;
 
 parameter_list: parameter_declaration_group
-    { $$ = new ParameterList($1, lin, col); }
+    { $$ = new (ctx->arena) ParameterList(ctx->arena, $1, ctx->lin, ctx->col); }
     | parameter_list ';' parameter_declaration_group
     { $1->addParameterDeclarationGroup($3); $$ = $1; }
     ;
 
 parameter_declaration_group: identifier_list ':' type
-    { $$ = new ParameterDeclaration($1, $3, lin, col); }
+    { $$ = new (ctx->arena) ParameterDeclaration($1, $3, ctx->lin, ctx->col); }
     ;
 
 compound_statement: BEGIN_TOKEN optional_statements END_TOKEN
-    { $$ = new CompoundStatementNode($2, lin, col); }
+    { $$ = new (ctx->arena) CompoundStatementNode($2, ctx->lin, ctx->col); }
     ;
 
 optional_statements: /* empty */
-    { $$ = new StatementList(lin, col); }
+    { $$ = new (ctx->arena) StatementList(ctx->arena, ctx->lin, ctx->col); }
     | statement_list_terminated
     { $$ = $1; }
     ;
@@ -211,44 +262,48 @@ statement_list_terminated: statement_list
     ;
 
 statement_list: statement
-    { $$ = new StatementList(lin, col); $$->addStatement($1); }
+    { $$ = new (ctx->arena) StatementList(ctx->arena, ctx->lin, ctx->col); $$->addStatement($1); }
     | statement_list ';' statement
     { $1->addStatement($3); $$ = $1; }
+    | statement_list error // e.g. a missing ';': keep what came before, resume at the next ';' or END
+    { $$ = $1; }
     ;
 
 statement: variable ASSIGN_OP expr  // Use new 'expr' non-terminal
-    { $$ = new AssignStatementNode($1, $3, lin, col); }
+    { $$ = new (ctx->arena) AssignStatementNode($1, $3, ctx->lin, ctx->col); }
     | procedure_statement
     { $$ = $1; }
     | compound_statement
     { $$ = $1; }
     | IF expr THEN statement %prec THEN // Use new 'expr' non-terminal
-    { $$ = new IfStatementNode($2, $4, nullptr, lin, col); }
+    { $$ = new (ctx->arena) IfStatementNode($2, $4, nullptr, ctx->lin, ctx->col); }
     | IF expr THEN statement ELSE statement // Use new 'expr' non-terminal
-    { $$ = new IfStatementNode($2, $4, $6, lin, col); }
+    { $$ = new (ctx->arena) IfStatementNode($2, $4, $6, ctx->lin, ctx->col); }
     | WHILE expr DO statement // Use new 'expr' non-terminal
-    { $$ = new WhileStatementNode($2, $4, lin, col); }
+    { $$ = new (ctx->arena) WhileStatementNode($2, $4, ctx->lin, ctx->col); }
     | return_statement
+    | error
+    { $$ = new (ctx->arena) CompoundStatementNode(new (ctx->arena) StatementList(ctx->arena, ctx->lin, ctx->col), ctx->lin, ctx->col); }
     ;
 
 return_statement: RETURN_KEYWORD expr
-    { $$ = new ReturnStatementNode($2, lin, col); } // $2 is the ExprNode
+    { $$ = new (ctx->arena) ReturnStatementNode($2, ctx->lin, ctx->col); } // $2 is the ExprNode
     ;
 
 variable: id_node
-    { $$ = new VariableNode($1, nullptr, lin, col); }
+    { $$ = new (ctx->arena) VariableNode($1, nullptr, ctx->lin, ctx->col); }
     | id_node '[' expr ']' // Use new 'expr' non-terminal for array index
-    { $$ = new VariableNode($1, $3, lin, col); }
+    { $$ = new (ctx->arena) VariableNode($1, $3, ctx->lin, ctx->col); }
     ;
 
 procedure_statement: id_node
-    { $$ = new ProcedureCallStatementNode($1, new ExpressionList(lin,col), lin, col); }
+    { $$ = new (ctx->arena) ProcedureCallStatementNode($1, new (ctx->arena) ExpressionList(ctx->arena, ctx->lin, ctx->col), ctx->lin, ctx->col); }
     | id_node '(' expression_list ')'
-    { $$ = new ProcedureCallStatementNode($1, $3, lin, col); }
+    { $$ = new (ctx->arena) ProcedureCallStatementNode($1, $3, ctx->lin, ctx->col); }
     ;
 
 expression_list: expr // Use new 'expr' non-terminal
-    { $$ = new ExpressionList(lin, col); $$->addExpression($1); }
+    { $$ = new (ctx->arena) ExpressionList(ctx->arena, ctx->lin, ctx->col); $$->addExpression($1); }
     | expression_list ',' expr // Use new 'expr' non-terminal
     { $1->addExpression($3); $$ = $1; }
     ;
@@ -262,13 +317,13 @@ expr: logical_or_expr
 logical_or_expr: logical_and_expr
                  { $$ = $1; }
                | logical_or_expr OR_OP logical_and_expr
-                 { $$ = new BinaryOpNode($1, "OR_OP", $3, lin, col); }
+                 { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::OR, $3, ctx->lin, ctx->col); }
                ;
 
 logical_and_expr: not_expr
                   { $$ = $1; }
                 | logical_and_expr AND_OP not_expr
-                  { $$ = new BinaryOpNode($1, "AND_OP", $3, lin, col); }
+                  { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::AND, $3, ctx->lin, ctx->col); }
                 ;
 
 not_expr: relational_expr
@@ -277,74 +332,79 @@ not_expr: relational_expr
                           // This makes NOT left-recursive (effectively right-associative for unary)
                           // and its precedence relative to relational_expr is determined
                           // by the cascade and the NOT_OP precedence declaration.
-          { $$ = new UnaryOpNode("NOT_OP", $2, lin, col); }
+          { $$ = new (ctx->arena) UnaryOpNode(UnaryOperator::NOT, $2, ctx->lin, ctx->col); }
         ;
 
 relational_expr: additive_expr
                  { $$ = $1; }
                | relational_expr EQ_OP additive_expr  // Using left-recursion for left-associativity
-                 { $$ = new BinaryOpNode($1, "EQ_OP", $3, lin, col); }
+                 { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::EQ, $3, ctx->lin, ctx->col); }
                | relational_expr NEQ_OP additive_expr
-                 { $$ = new BinaryOpNode($1, "NEQ_OP", $3, lin, col); }
+                 { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::NEQ, $3, ctx->lin, ctx->col); }
                | relational_expr LT_OP additive_expr
-                 { $$ = new BinaryOpNode($1, "LT_OP", $3, lin, col); }
+                 { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::LT, $3, ctx->lin, ctx->col); }
                | relational_expr LTE_OP additive_expr
-                 { $$ = new BinaryOpNode($1, "LTE_OP", $3, lin, col); }
+                 { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::LTE, $3, ctx->lin, ctx->col); }
                | relational_expr GT_OP additive_expr
-                 { $$ = new BinaryOpNode($1, "GT_OP", $3, lin, col); }
+                 { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::GT, $3, ctx->lin, ctx->col); }
                | relational_expr GTE_OP additive_expr
-                 { $$ = new BinaryOpNode($1, "GTE_OP", $3, lin, col); }
+                 { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::GTE, $3, ctx->lin, ctx->col); }
                ;
 
 additive_expr: multiplicative_expr
                { $$ = $1; }
              | additive_expr '+' multiplicative_expr
-               { $$ = new BinaryOpNode($1, "+", $3, lin, col); }
+               { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::ADD, $3, ctx->lin, ctx->col); }
              | additive_expr '-' multiplicative_expr
-               { $$ = new BinaryOpNode($1, "-", $3, lin, col); }
+               { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::SUB, $3, ctx->lin, ctx->col); }
              ;
 
 multiplicative_expr: unary_expr
                      { $$ = $1; }
                    | multiplicative_expr '*' unary_expr
-                     { $$ = new BinaryOpNode($1, "*", $3, lin, col); }
+                     { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::MUL, $3, ctx->lin, ctx->col); }
                    | multiplicative_expr '/' unary_expr
-                     { $$ = new BinaryOpNode($1, "/", $3, lin, col); }
+                     { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::REAL_DIV, $3, ctx->lin, ctx->col); }
                    | multiplicative_expr DIV_OP unary_expr
-                     { $$ = new BinaryOpNode($1, "DIV_OP", $3, lin, col); }
+                     { $$ = new (ctx->arena) BinaryOpNode($1, BinaryOperator::INT_DIV, $3, ctx->lin, ctx->col); }
                    ;
 
 unary_expr: primary
             { $$ = $1; }
           | '-' primary %prec UMINUS // UMINUS applies to a primary expression
-            { $$ = new UnaryOpNode("-", $2, lin, col); }
+            { $$ = new (ctx->arena) UnaryOpNode(UnaryOperator::NEG, $2, ctx->lin, ctx->col); }
           ;
 
 primary: id_node '[' expr ']' // Added for array access in expressions
-           { $$ = new VariableNode($1, $3, $1->line, $1->column); }
+           { $$ = new (ctx->arena) VariableNode($1, $3, $1->line, $1->column); }
          | id_node '(' expression_list ')' // Function call with ()
-           { $$ = new FunctionCallExprNode($1, $3, $1->line, $1->column); }
+           { $$ = new (ctx->arena) FunctionCallExprNode($1, $3, $1->line, $1->column); }
          | id_node // Simple identifier (can be a var, param, or parameterless function)
-           { $$ = new IdExprNode($1, $1->line, $1->column); }
+           { $$ = new (ctx->arena) IdExprNode($1, $1->line, $1->column); }
          | int_num_node
            { $$ = $1; }
          | real_num_node
            { $$ = $1; }
          | TRUE_KEYWORD
-           { $$ = new BooleanLiteralNode(true, lin, col); }
+           { $$ = new (ctx->arena) BooleanLiteralNode(true, ctx->lin, ctx->col); }
          | FALSE_KEYWORD
-           { $$ = new BooleanLiteralNode(false, lin, col); }
+           { $$ = new (ctx->arena) BooleanLiteralNode(false, ctx->lin, ctx->col); }
          | '(' expr ')'
            { $$ = $2; }
          | STRING_LITERAL 
-         { $$ = new StringLiteralNode($1, lin, col); }
+         { $$ = new (ctx->arena) StringLiteralNode(ctx->arena.copy($1.view()), ctx->lin, ctx->col); }
        ;
 
 %%
 
+// Replays the buffered token stream instead of running the scanner a second time.
+int yylex(YYSTYPE* lval, CompilationContext* ctx) {
+    return ctx->tokens.next(*lval, ctx->lin, ctx->col);
+}
+
 // Standardized yyerror function
-int yyerror(const char* s) {
-    compilation_has_error = true; 
-    fprintf(stderr, "Syntax Error (L:%d, C:%d): %s\n", lin, col, s);
+int yyerror(CompilationContext* ctx, const char* s) {
+    ctx->has_error = true;
+    *ctx->err << "Syntax Error (L:" << ctx->lin << ", C:" << ctx->col << "): " << s << std::endl;
     return 0;
 }
\ No newline at end of file
@@ -1,45 +1,231 @@
-#include "ast.h"
-#include "parser.h"
-#include "semantic_analyzer.h"
-#include "codegenerator.h"
+#include "compiler.h"
+#include "thread_pool.h"
+#include "server.h"
+#include "time_report.h"
+#include "trace.h"
+#include "cache_directory.h"
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <cstdlib>
 #include <string>
 #include <vector>
+#include <set>
+#include <functional>
+#include <memory>
 #include <filesystem> // For creating directories (C++17)
 
-// External variables from Flex/Bison
-extern ProgramNode* root_ast_node;
-extern int yylex();
-extern int yyparse();
-extern FILE* yyin;
-extern int lin;
-extern int col;
-extern YYSTYPE yylval;
-
-// Global error flag, set by lexer or parser on error
-bool compilation_has_error = false;
-
-// Helper function to get token names (must be declared)
-const char* token_to_string(int token, const YYSTYPE& lval);
-
-// Helper function to get the base name of a file path
-std::string get_base_filename(const std::string& path) {
-    size_t last_slash = path.find_last_of("/\\");
-    std::string filename = (last_slash == std::string::npos) ? path : path.substr(last_slash + 1);
-    size_t last_dot = filename.find_last_of('.');
-    return (last_dot == std::string::npos) ? filename : filename.substr(0, last_dot);
+static void printUsage() {
+    std::cerr << "Usage: ./my_compiler [-j N] [--emit=tokens,ast,sema,asm] [--scanner=flex|fast] [--time-report[=table|json]] [--trace=<out.json>] [--cache-dir=DIR [--cache-size=MB]] [--client <socket>] <input_file.pas> [more_files.pas ... | @file_list.txt]" << std::endl;
+    std::cerr << "       ./my_compiler [-j N] [--cache-dir=DIR [--cache-size=MB]] --server <socket>" << std::endl;
+    std::cerr << "       ./my_compiler --cache-dir=DIR --cache-stats" << std::endl;
+    std::cerr << "       ./my_compiler --shutdown <socket>" << std::endl;
+}
+
+// Reads a response file: one input path per line. Blank lines and lines
+// starting with '#' are skipped.
+static bool readResponseFile(const std::string& path, std::vector<std::string>& inputs) {
+    std::ifstream list(path);
+    if (!list) {
+        std::cerr << "Error: Could not open response file " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(list, line)) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        size_t last = line.find_last_not_of(" \t\r");
+        inputs.push_back(line.substr(first, last - first + 1));
+    }
+    return true;
+}
+
+// Outcome of one file in batch mode, reported once the whole batch is done.
+struct BatchResult {
+    CompileStatus status = CompileStatus::IO_ERROR;
+    std::string diagnostics;
+};
+
+// Compiles one file described by a context, locally or on a compile server.
+using CompileFn = std::function<CompileStatus(CompilationContext&)>;
+
+// Compiles every input on a work-stealing pool. Progress chatter is dropped;
+// each file's diagnostics are buffered and printed in input order, followed by
+// a per-file status summary, so the output doesn't depend on scheduling.
+static int runBatch(const std::vector<std::string>& inputs, const std::string& output_dir, unsigned emit, unsigned jobs, const CompileFn& compile) {
+    // Two inputs with the same base name would race for the same output files.
+    std::set<std::string> base_names;
+    for (const std::string& input : inputs) {
+        if (!base_names.insert(get_base_filename(input)).second) {
+            std::cerr << "Error: More than one input would write " << output_dir << "/" << get_base_filename(input) << ".*" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<BatchResult> results(inputs.size());
+    {
+        WorkStealingPool pool(jobs);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            pool.submit([&, i] {
+                std::ostream quiet(nullptr);
+                std::ostringstream diagnostics;
+
+                CompilationContext ctx;
+                ctx.input_filename = inputs[i];
+                ctx.base_name = get_base_filename(inputs[i]);
+                ctx.output_dir = output_dir;
+                ctx.emit = emit;
+                ctx.out = &quiet;
+                ctx.err = &diagnostics;
+
+                results[i].status = compile(ctx);
+                results[i].diagnostics = diagnostics.str();
+            });
+        }
+        pool.wait();
+    }
+
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (!results[i].diagnostics.empty()) {
+            std::cerr << "--- " << inputs[i] << " ---" << std::endl;
+            std::cerr << results[i].diagnostics;
+        }
+    }
+
+    size_t failed = 0;
+    std::cout << "--- Batch Summary ---" << std::endl;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (results[i].status == CompileStatus::SUCCESS) {
+            std::cout << "[OK]     " << inputs[i] << std::endl;
+        }
+        else {
+            failed++;
+            std::cout << "[FAILED] " << inputs[i] << " (" << compileStatusToString(results[i].status) << ")" << std::endl;
+        }
+    }
+    std::cout << (inputs.size() - failed) << " succeeded, " << failed << " failed, " << inputs.size() << " total." << std::endl;
+    return failed == 0 ? 0 : 1;
 }
 
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: ./my_compiler <input_file.pas>" << std::endl;
+    std::vector<std::string> inputs;
+    bool batch = false;
+    unsigned jobs = 0; // 0 = one worker per hardware thread
+    std::string server_socket;
+    std::string client_socket;
+    std::string shutdown_socket;
+    std::string time_report; // "", "table" or "json"
+    std::string trace_path;
+    std::string cache_dir;
+    uint64_t cache_size = CacheDirectory::DEFAULT_MAX_BYTES;
+    bool cache_stats = false;
+    unsigned emit = EMIT_ASM;
+    ScannerKind scanner = SCANNER_FLEX;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "-j" && i + 1 < argc) {
+            jobs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg.rfind("--jobs=", 0) == 0) {
+            jobs = static_cast<unsigned>(std::strtoul(arg.c_str() + 7, nullptr, 10));
+        }
+        else if (arg == "--server" && i + 1 < argc) {
+            server_socket = argv[++i];
+        }
+        else if (arg == "--client" && i + 1 < argc) {
+            client_socket = argv[++i];
+        }
+        else if (arg == "--shutdown" && i + 1 < argc) {
+            shutdown_socket = argv[++i];
+        }
+        else if (arg == "--time-report" || arg == "--time-report=table") {
+            time_report = "table";
+        }
+        else if (arg == "--time-report=json") {
+            time_report = "json";
+        }
+        else if (arg.rfind("--emit=", 0) == 0) {
+            if (!parseEmitList(arg.substr(7), emit)) {
+                std::cerr << "Error: --emit takes a comma-separated list of tokens, ast, sema and asm" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg.rfind("--scanner=", 0) == 0) {
+            if (!parseScannerName(arg.substr(10), scanner)) {
+                std::cerr << "Error: --scanner takes flex or fast" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg.rfind("--trace=", 0) == 0 && arg.size() > 8) {
+            trace_path = arg.substr(8);
+        }
+        else if (arg.rfind("--cache-dir=", 0) == 0 && arg.size() > 12) {
+            cache_dir = arg.substr(12);
+        }
+        else if (arg.rfind("--cache-size=", 0) == 0) {
+            char* end;
+            unsigned long long megabytes = std::strtoull(arg.c_str() + 13, &end, 10);
+            if (end == arg.c_str() + 13 || *end != '\0' || megabytes == 0) {
+                std::cerr << "Error: --cache-size takes a size in megabytes" << std::endl;
+                return 1;
+            }
+            cache_size = megabytes * 1024 * 1024;
+        }
+        else if (arg == "--cache-stats") {
+            cache_stats = true;
+        }
+        else if (arg.size() > 1 && arg[0] == '@') {
+            if (!readResponseFile(arg.substr(1), inputs)) return 1;
+            batch = true;
+        }
+        else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "Error: Unknown option " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+        else {
+            inputs.push_back(arg);
+        }
+    }
+    std::unique_ptr<CacheDirectory> cache;
+    if (!cache_dir.empty()) {
+        // A client's cache is the server's business (--server --cache-dir).
+        if (!client_socket.empty() || !shutdown_socket.empty()) {
+            std::cerr << "Error: --cache-dir can't be combined with --client or --shutdown" << std::endl;
+            return 1;
+        }
+        cache = std::make_unique<CacheDirectory>(cache_dir, cache_size);
+        if (!cache->ok()) {
+            std::cerr << "Error: Could not create cache directory " << cache_dir << std::endl;
+            return 1;
+        }
+    }
+    if (cache_stats) {
+        if (!cache || !inputs.empty() || !server_socket.empty()) {
+            printUsage();
+            return 1;
+        }
+        cache->printStats(std::cout);
+        return 0;
+    }
+    if (!server_socket.empty() || !shutdown_socket.empty()) {
+        if (!inputs.empty() || !client_socket.empty() || !time_report.empty() || !trace_path.empty() || (!server_socket.empty() && !shutdown_socket.empty())) {
+            printUsage();
+            return 1;
+        }
+        if (!shutdown_socket.empty()) {
+            return shutdownServer(shutdown_socket) ? 0 : 1;
+        }
+        return runServer(server_socket, jobs, cache.get());
+    }
+    if (inputs.empty()) {
+        printUsage();
         return 1;
     }
+    batch = batch || inputs.size() > 1;
 
-    std::string input_filename(argv[1]);
-    std::string base_name = get_base_filename(input_filename);
     std::string output_dir = "output";
 
     // --- Create output directory ---
@@ -53,121 +239,65 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // --- Open input file ---
-    yyin = fopen(input_filename.c_str(), "r");
-    if (!yyin) {
-        std::cerr << "Error: Could not open file " << input_filename << std::endl;
-        return 1;
-    }
-
-    // =============================================
-    // PHASE 1: LEXICAL ANALYSIS
-    // =============================================
-    std::cout << "Phase 1: Lexical Analysis..." << std::endl;
-    std::string tokens_filepath = output_dir + "/" + base_name + ".tokens.txt";
-    std::ofstream tokens_file(tokens_filepath);
-    if (!tokens_file) {
-        std::cerr << "Error: Could not open tokens output file." << std::endl;
-        fclose(yyin);
-        return 1;
+    CompileFn compile = compileFile;
+    if (!client_socket.empty()) {
+        if (!time_report.empty() || !trace_path.empty()) {
+            std::cerr << "Error: --time-report and --trace can't be combined with --client" << std::endl;
+            return 1;
+        }
+        compile = [&client_socket](CompilationContext& ctx) { return compileRemote(client_socket, ctx); };
     }
-
-    int token;
-    tokens_file << "--- Token Stream ---" << std::endl;
-    while ((token = yylex()) != 0) {
-        tokens_file << "Token: " << token_to_string(token, yylval)
-            << " (ID: " << token << ")"
-            << " at (L:" << lin << ", C:" << col << ")";
-        if (token == IDENT) tokens_file << " - Value: " << yylval.rawIdent->name;
-        if (token == NUM) tokens_file << " - Value: " << yylval.rawNum->value;
-        if (token == REAL_LITERAL) tokens_file << " - Value: " << yylval.rawRealLit->value;
-        if (token == STRING_LITERAL) tokens_file << " - Value: \"" << yylval.str_val << "\"";
-        tokens_file << std::endl;
+    if (!time_report.empty()) {
+        // The report follows the file's other diagnostics on stderr (buffered per file in batch mode).
+        compile = [local = compile, &time_report](CompilationContext& ctx) {
+            TimeReport report;
+            ctx.time_report = &report;
+            CompileStatus status = local(ctx);
+            ctx.time_report = nullptr;
+            if (time_report == "json") report.printJson(*ctx.err, ctx.input_filename);
+            else report.printTable(*ctx.err, ctx.input_filename);
+            return status;
+        };
     }
-    tokens_file.close();
 
-    if (compilation_has_error) {
-        std::cerr << "Lexical analysis failed." << std::endl;
-        fclose(yyin);
-        return 1;
+    if (scanner != SCANNER_FLEX) {
+        compile = [local = compile, scanner](CompilationContext& ctx) {
+            ctx.scanner = scanner;
+            return local(ctx);
+        };
     }
-    std::cout << "Lexical analysis successful. Token list written to " << tokens_filepath << std::endl;
-
-    // Reset file and lexer for parsing phase
-    rewind(yyin);
-    lin = 1;
-    col = 1;
-
-    // =============================================
-    // PHASE 2: SYNTAX ANALYSIS (PARSING)
-    // =============================================
-    std::cout << "\nPhase 2: Syntax Analysis..." << std::endl;
-    int parse_result = yyparse();
 
-    if (parse_result != 0 || compilation_has_error || root_ast_node == nullptr) {
-        std::cerr << "Syntax analysis failed." << std::endl;
-        fclose(yyin);
-        return 1;
+    if (cache) {
+        compile = [local = compile, &cache](CompilationContext& ctx) {
+            ctx.cache = cache.get();
+            return local(ctx);
+        };
     }
-    std::cout << "Parsing successful!" << std::endl;
-
-    std::string ast_filepath = output_dir + "/" + base_name + ".ast.txt";
-    std::ofstream ast_file(ast_filepath);
-    root_ast_node->print(ast_file);
-    ast_file.close();
-    std::cout << "AST dump written to " << ast_filepath << std::endl;
-
-
-    // =============================================
-    // PHASE 3: SEMANTIC ANALYSIS
-    // =============================================
-    std::cout << "\nPhase 3: Semantic Analysis..." << std::endl;
-    SemanticAnalyzer semanticAnalyzer;
-    root_ast_node->accept(semanticAnalyzer);
 
-    std::string semantics_filepath = output_dir + "/" + base_name + ".semantic_analysis.log";
-    std::ofstream semantics_file(semantics_filepath);
-
-    if (semanticAnalyzer.hasErrors()) {
-        std::cerr << "Semantic analysis failed. See log for details." << std::endl;
-        semantics_file << "--- SEMANTIC ERRORS ---" << std::endl;
-        semanticAnalyzer.printErrors(semantics_file);
-        delete root_ast_node;
-        fclose(yyin);
-        semantics_file.close();
-        return 1;
+    TraceRecorder trace;
+    if (!trace_path.empty()) {
+        compile = [local = compile, &trace](CompilationContext& ctx) {
+            ctx.trace = &trace;
+            return local(ctx);
+        };
     }
-    std::cout << "Semantic analysis successful!" << std::endl;
-    semantics_file << "Semantic analysis successful. No errors found." << std::endl;
-    semantics_file.close();
 
-
-    // =============================================
-    // PHASE 4: CODE GENERATION
-    // =============================================
-    std::cout << "\nPhase 4: Code Generation..." << std::endl;
-    CodeGenerator codeGenerator;
-    std::string assemblyCode;
-    try {
-        assemblyCode = codeGenerator.generateCode(*root_ast_node, semanticAnalyzer);
+    int exit_code;
+    if (batch) {
+        exit_code = runBatch(inputs, output_dir, emit, jobs, compile);
     }
-    catch (const std::runtime_error& e) {
-        std::cerr << "Code generation crashed: " << e.what() << std::endl;
-        delete root_ast_node;
-        fclose(yyin);
-        return 1;
+    else {
+        CompilationContext ctx;
+        ctx.input_filename = inputs.front();
+        ctx.base_name = get_base_filename(ctx.input_filename);
+        ctx.output_dir = output_dir;
+        ctx.emit = emit;
+        exit_code = compile(ctx) == CompileStatus::SUCCESS ? 0 : 1;
     }
 
-    std::string vm_filepath = output_dir + "/" + base_name + ".assembly.vm";
-    std::ofstream vm_file(vm_filepath);
-    vm_file << assemblyCode;
-    vm_file.close();
-    std::cout << "Code generation successful! Assembly written to " << vm_filepath << std::endl;
-    std::cout << "Run with: ./vm.exe " << vm_filepath << std::endl;
-
-    // --- Cleanup ---
-    delete root_ast_node;
-    fclose(yyin);
-
-    return 0;
+    if (!trace_path.empty() && !trace.writeJson(trace_path)) {
+        std::cerr << "Error: Could not write trace file " << trace_path << std::endl;
+        exit_code = 1;
+    }
+    return exit_code;
 }
@@ -0,0 +1,318 @@
+#include "result_cache.h"
+#include "compiler.h"
+#include <streambuf>
+#include <utility>
+#include <vector>
+
+// Bump whenever the entry layout changes.
+static const uint32_t FORMAT_VERSION = 3;
+static const char* const EXTENSION = ".res";
+
+// Record tags. After the version come ARTIFACT records, each the suffix,
+// chunks of (uint32 size, bytes) up to a zero size and a kept flag, then
+// END, the status and the transcript.
+static const uint8_t RECORD_END = 0;
+static const uint8_t RECORD_ARTIFACT = 1;
+
+// Each transcript chunk is stored as pieces: plain text, or the suffix of an
+// artifact whose location the log printed there.
+static const uint8_t PIECE_TEXT = 0;
+static const uint8_t PIECE_LOCATION = 1;
+
+// Artifact bytes are buffered up to this much per chunk.
+static const size_t CHUNK_SIZE = 64 * 1024;
+
+ResultCache::ResultCache(CacheDirectory& dir, CompilationContext& ctx) : directory(dir) {
+    key = CacheKeyBuilder()
+        .add(compilerBuildId())
+        .add(emitListToString(ctx.emit))
+        .add(scannerName(ctx.scanner))
+        .add(std::string_view(ctx.source.data(), ctx.source.size()))
+        .finish();
+}
+
+// --- Reading ---
+
+// Steps over one artifact record after its tag; hands each chunk to 'write'
+// if there is one. False if the record is cut short.
+template <typename Write>
+static bool readArtifact(CacheReader& in, std::string_view& suffix, bool& kept, Write write) {
+    if (!in.getString(suffix)) return false;
+    for (;;) {
+        uint32_t size;
+        const char* bytes;
+        if (!in.get(size)) return false;
+        if (size == 0) break;
+        if (!in.getBytes(size, bytes)) return false;
+        write(bytes, size);
+    }
+    uint8_t flag;
+    if (!in.get(flag)) return false;
+    kept = flag != 0;
+    return true;
+}
+
+bool ResultCache::load(StoredResult& out, const ArtifactStore& artifacts) const {
+    bool found = directory.fetch(key, EXTENSION, out.entry);
+    directory.count(found ? CacheDirectory::RESULT_HIT : CacheDirectory::RESULT_MISS);
+    if (!found) return false;
+
+    CacheReader in(out.entry.body());
+    uint32_t version;
+    if (!in.get(version) || version != FORMAT_VERSION) return false;
+    const char* records = out.entry.body().data() + sizeof version;
+    for (;;) {
+        uint8_t tag;
+        std::string_view suffix;
+        bool kept;
+        if (!in.get(tag)) return false;
+        if (tag == RECORD_END) break;
+        if (tag != RECORD_ARTIFACT || !readArtifact(in, suffix, kept, [](const char*, size_t) {})) return false;
+    }
+    // Up to and including the END tag
+    out.records = std::string_view(records, static_cast<size_t>(in.position() - records));
+
+    uint8_t status;
+    uint32_t chunkCount;
+    if (!in.get(status) || status > static_cast<uint8_t>(CompileStatus::CODEGEN_ERROR) || !in.get(chunkCount)) {
+        return false;
+    }
+    out.status = static_cast<CompileStatus>(status);
+    out.transcript.clear();
+    for (uint32_t i = 0; i < chunkCount; i++) {
+        uint8_t diagnostic;
+        uint32_t pieceCount;
+        if (!in.get(diagnostic) || !in.get(pieceCount)) return false;
+        std::string text;
+        for (uint32_t j = 0; j < pieceCount; j++) {
+            uint8_t kind;
+            std::string_view piece;
+            if (!in.get(kind) || kind > PIECE_LOCATION || !in.getString(piece)) return false;
+            if (kind == PIECE_LOCATION) {
+                text += artifacts.location(std::string(piece));
+            }
+            else {
+                text += piece;
+            }
+        }
+        out.transcript.emplace_back(diagnostic != 0, std::move(text));
+    }
+    return in.atEnd();
+}
+
+// The records were checked by load(), so only writing can fail here.
+bool StoredResult::writeArtifacts(ArtifactStore& artifacts, std::string& failed) const {
+    CacheReader in(records);
+    uint8_t tag;
+    while (in.get(tag) && tag == RECORD_ARTIFACT) {
+        std::string_view suffix;
+        bool kept;
+        CacheReader record = in;
+        readArtifact(in, suffix, kept, [](const char*, size_t) {});
+        std::string name(suffix);
+        if (!kept) {
+            artifacts.discard(name);
+            continue;
+        }
+        std::ostream* file = artifacts.open(name);
+        if (!file) {
+            failed = name;
+            return false;
+        }
+        readArtifact(record, suffix, kept,
+            [file](const char* bytes, size_t size) { file->write(bytes, static_cast<std::streamsize>(size)); });
+        artifacts.close(name);
+    }
+    return true;
+}
+
+// --- Recording ---
+
+std::unique_ptr<ResultRecorder> ResultCache::record(ArtifactStore& artifacts) const {
+    std::unique_ptr<PendingEntry> pending = directory.begin(key, EXTENSION);
+    if (!pending) return nullptr;
+    return std::make_unique<ResultRecorder>(artifacts, directory, std::move(pending));
+}
+
+// What ResultRecorder::open() returns: writes go to the target's stream and
+// into the entry.
+class ResultRecorder::TeeStream : public std::streambuf {
+private:
+    ResultRecorder& recorder;
+    std::ostream* target;
+
+protected:
+    int overflow(int ch) override {
+        if (ch != traits_type::eof()) {
+            char c = static_cast<char>(ch);
+            xsputn(&c, 1);
+        }
+        return ch;
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        target->write(s, n);
+        recorder.append(s, static_cast<size_t>(n));
+        return n;
+    }
+    int sync() override {
+        target->flush();
+        return 0;
+    }
+
+public:
+    std::ostream stream;
+
+    TeeStream(ResultRecorder& r, std::ostream* t) : recorder(r), target(t), stream(this) {}
+};
+
+// The same for ResultRecorder::openSink()
+class ResultRecorder::TeeSink : public CodeSink {
+private:
+    ResultRecorder& recorder;
+    std::unique_ptr<CodeSink> target;
+    std::string suffix;
+
+public:
+    TeeSink(ResultRecorder& r, std::unique_ptr<CodeSink> t, std::string s)
+        : recorder(r), target(std::move(t)), suffix(std::move(s)) {}
+
+    void write(const char* data, size_t size) override {
+        target->write(data, size);
+        recorder.append(data, size);
+    }
+    bool finish() override {
+        recorder.endArtifact(suffix);
+        return target->finish();
+    }
+};
+
+ResultRecorder::ResultRecorder(ArtifactStore& artifacts, CacheDirectory& dir, std::unique_ptr<PendingEntry> pending)
+    : target(artifacts), directory(dir), entry(std::move(pending)) {
+    entry->out().put(FORMAT_VERSION);
+}
+
+ResultRecorder::~ResultRecorder() = default;
+
+void ResultRecorder::startArtifact(const std::string& suffix) {
+    settle(true);
+    CacheWriter& out = entry->out();
+    out.put(RECORD_ARTIFACT);
+    out.putString(suffix);
+    current = suffix;
+    state = WRITING;
+}
+
+void ResultRecorder::append(const char* data, size_t size) {
+    if (state != WRITING) return;
+    chunk.append(data, size);
+    if (chunk.size() >= CHUNK_SIZE) flushChunk();
+}
+
+void ResultRecorder::flushChunk() {
+    if (chunk.empty()) return;
+    CacheWriter& out = entry->out();
+    out.put(static_cast<uint32_t>(chunk.size()));
+    out.write(chunk.data(), chunk.size());
+    chunk.clear();
+}
+
+void ResultRecorder::endArtifact(const std::string& suffix) {
+    if (state != WRITING || current != suffix) return;
+    flushChunk();
+    entry->out().put(static_cast<uint32_t>(0));
+    state = ENDED;
+}
+
+// The kept flag waits until the next artifact starts, since a finished
+// artifact can still be discarded (the assembly, when writing it out fails).
+void ResultRecorder::settle(bool kept) {
+    endArtifact(current);
+    if (state != ENDED) return;
+    entry->out().put(static_cast<uint8_t>(kept));
+    state = IDLE;
+}
+
+std::ostream* ResultRecorder::open(const std::string& suffix) {
+    std::ostream* file = target.open(suffix);
+    if (!file) return nullptr;
+    startArtifact(suffix);
+    std::unique_ptr<TeeStream>& tee = streams[suffix];
+    tee = std::make_unique<TeeStream>(*this, file);
+    return &tee->stream;
+}
+
+void ResultRecorder::close(const std::string& suffix) {
+    streams.erase(suffix);
+    target.close(suffix);
+    endArtifact(suffix);
+}
+
+std::unique_ptr<CodeSink> ResultRecorder::openSink(const std::string& suffix) {
+    std::unique_ptr<CodeSink> sink = target.openSink(suffix);
+    if (!sink) return nullptr;
+    startArtifact(suffix);
+    return std::make_unique<TeeSink>(*this, std::move(sink), suffix);
+}
+
+void ResultRecorder::discard(const std::string& suffix) {
+    streams.erase(suffix);
+    target.discard(suffix);
+    if (state != IDLE && current == suffix) {
+        settle(false);
+        return;
+    }
+    // Not the artifact being recorded: replaying has to drop it all the same.
+    startArtifact(suffix);
+    endArtifact(suffix);
+    settle(false);
+}
+
+std::string ResultRecorder::location(const std::string& suffix) const {
+    std::string path = target.location(suffix);
+    if (!path.empty()) locations[suffix] = path;
+    return path;
+}
+
+// Splits 'text' at the locations the pipeline asked for, so a replay can
+// print them as its own store names them.
+static std::vector<std::pair<uint8_t, std::string_view>> splitLocations(
+    std::string_view text, const std::map<std::string, std::string>& locations) {
+    std::vector<std::pair<uint8_t, std::string_view>> pieces;
+    while (!text.empty()) {
+        size_t first = std::string_view::npos;
+        const std::pair<const std::string, std::string>* found = nullptr;
+        for (const auto& location : locations) {
+            size_t at = text.find(location.second);
+            if (at < first) {
+                first = at;
+                found = &location;
+            }
+        }
+        if (!found) {
+            pieces.emplace_back(PIECE_TEXT, text);
+            break;
+        }
+        if (first > 0) pieces.emplace_back(PIECE_TEXT, text.substr(0, first));
+        pieces.emplace_back(PIECE_LOCATION, found->first);
+        text.remove_prefix(first + found->second.size());
+    }
+    return pieces;
+}
+
+bool ResultRecorder::finish(CompileStatus status, const Transcript& transcript) {
+    settle(true);
+    CacheWriter& out = entry->out();
+    out.put(RECORD_END);
+    out.put(static_cast<uint8_t>(status));
+    out.put(static_cast<uint32_t>(transcript.size()));
+    for (const auto& chunk : transcript) {
+        std::vector<std::pair<uint8_t, std::string_view>> pieces = splitLocations(chunk.second, locations);
+        out.put(static_cast<uint8_t>(chunk.first));
+        out.put(static_cast<uint32_t>(pieces.size()));
+        for (const auto& piece : pieces) {
+            out.put(piece.first);
+            out.putString(piece.second);
+        }
+    }
+    return directory.commit(std::move(entry));
+}
@@ -0,0 +1,105 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "artifact_store.h"
+#include "cache_directory.h"
+#include "compilation_context.h"
+#include "compile_status.h"
+#include "transcript.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+class ResultRecorder;
+
+// A finished compilation as a cache entry holds it: how it ended and what it
+// printed, read out up front, and the artifacts, which stay in the mapped
+// entry until writeArtifacts() copies them out.
+class StoredResult {
+private:
+    friend class ResultCache;
+    CacheEntry entry;
+    std::string_view records; // the artifacts, as ResultRecorder wrote them
+
+public:
+    CompileStatus status = CompileStatus::SUCCESS;
+    Transcript transcript;
+
+    // Writes the artifacts to 'artifacts' (and drops those the compilation
+    // discarded). False if one can't be written; 'failed' is its suffix.
+    bool writeArtifacts(ArtifactStore& artifacts, std::string& failed) const;
+};
+
+// Finished compilations in a CacheDirectory (--cache-dir), as <key>.res
+// entries. The key covers the compiler build, the options that shape the
+// output (--emit, --scanner) and the source text, so a hit can stand in for
+// the whole pipeline. The file names are not part of it: the log keeps the
+// artifact locations it printed as references, and a hit prints them as the
+// current compilation's store names them.
+//
+// An entry holds the artifacts in the order they were written, in chunks, and
+// then the status and the log. That way it is written while the compilation
+// runs (see ResultRecorder), and the artifacts never have to be held in
+// memory on the way in or out.
+class ResultCache {
+private:
+    CacheDirectory& directory;
+    CacheKey key;
+
+public:
+    // Cache entry for compiling ctx.source as ctx describes
+    ResultCache(CacheDirectory& dir, CompilationContext& ctx);
+
+    // False on a miss, or if the entry doesn't read back in full. The log's
+    // artifact locations are filled in from 'artifacts'.
+    bool load(StoredResult& out, const ArtifactStore& artifacts) const;
+    // Starts recording this compilation's entry, passing its artifacts on to
+    // 'artifacts'; nullptr if the entry can't be created.
+    std::unique_ptr<ResultRecorder> record(ArtifactStore& artifacts) const;
+};
+
+// Passes every artifact through to another store and copies it into a result
+// entry on the way, so a compilation on a cache miss still streams its output
+// to the files. Artifacts are recorded one at a time, as the pipeline writes
+// them: opening one ends the one before.
+class ResultRecorder : public ArtifactStore {
+private:
+    class TeeStream;
+    class TeeSink;
+    enum State { IDLE, WRITING, ENDED };
+
+    ArtifactStore& target;
+    CacheDirectory& directory;
+    std::unique_ptr<PendingEntry> entry;
+    std::map<std::string, std::unique_ptr<TeeStream>> streams;
+    State state = IDLE;
+    std::string current; // suffix of the artifact being recorded
+    std::string chunk;   // its bytes not yet in the entry
+    // Every location handed out, by suffix, to find in the log
+    mutable std::map<std::string, std::string> locations;
+
+    void startArtifact(const std::string& suffix);
+    void append(const char* data, size_t size);
+    void flushChunk();
+    void endArtifact(const std::string& suffix);
+    // Settles the last artifact, as kept or as discarded.
+    void settle(bool kept);
+
+public:
+    ResultRecorder(ArtifactStore& artifacts, CacheDirectory& dir, std::unique_ptr<PendingEntry> pending);
+    ~ResultRecorder() override;
+
+    std::ostream* open(const std::string& suffix) override;
+    void close(const std::string& suffix) override;
+    std::unique_ptr<CodeSink> openSink(const std::string& suffix) override;
+    void discard(const std::string& suffix) override;
+    std::string location(const std::string& suffix) const override;
+
+    // Ends the entry with how the compilation ended and what it printed, and
+    // stores it; false if that failed. Nothing is stored without this.
+    bool finish(CompileStatus status, const Transcript& transcript);
+};
+
+#endif // RESULT_CACHE_H
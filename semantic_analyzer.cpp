@@ -1,9 +1,11 @@
 #include "semantic_analyzer.h"
+#include "trace.h"
 #include <iostream>
 #include <sstream> // Needed for building the mangled name
+#include <limits>
 
 // Constructor: Pre-populate symbol table with built-in I/O procedures
-SemanticAnalyzer::SemanticAnalyzer() : currentFunctionContext(nullptr), global_offset(0), local_offset(0), param_offset(0) {
+SemanticAnalyzer::SemanticAnalyzer(StringInterner& names) : symbolTable(names), currentFunctionContext(nullptr), global_offset(0), local_offset(0), param_offset(0) {
     // MODIFIED: Explicitly define built-ins as procedures.
     // They are handled by special case logic and are not mangled.
     std::vector<std::pair<EntryTypeCategory, ArrayDetails>> empty_signature;
@@ -18,6 +20,18 @@ void SemanticAnalyzer::recordError(const std::string& message, int line, int col
     semanticErrors.push_back(error);
 }
 
+bool SemanticAnalyzer::checkIntegerRange(const IntNumNode& literal, bool negated) {
+    // Literals come from the lexer as 64-bit values, but 'integer' is 32 bits
+    // wide. A literal is never negative itself, so -2147483648 is only in
+    // range when it is checked together with its minus sign.
+    int64_t limit = std::numeric_limits<int32_t>::max();
+    if (negated) limit = -static_cast<int64_t>(std::numeric_limits<int32_t>::min());
+    if (literal.value <= limit) return true;
+    recordError("Integer literal " + std::to_string(literal.value) + " is out of range for type integer (at most " +
+        std::to_string(limit) + (negated ? " after the minus sign" : "") + ").", literal.line, literal.column);
+    return false;
+}
+
 bool SemanticAnalyzer::hasErrors() const {
     return !semanticErrors.empty();
 }
@@ -73,10 +87,10 @@ EntryTypeCategory SemanticAnalyzer::astToSymbolType(TypeNode* astTypeNode, Array
         return EntryTypeCategory::UNKNOWN_TYPE;
     }
 
-    if (auto* stn = dynamic_cast<StandardTypeNode*>(astTypeNode)) {
+    if (auto* stn = dyn_cast<StandardTypeNode>(astTypeNode)) {
         return astStandardTypeToSymbolType(stn);
     }
-    else if (auto* atn = dynamic_cast<ArrayTypeNode*>(astTypeNode)) {
+    else if (auto* atn = dyn_cast<ArrayTypeNode>(astTypeNode)) {
         if (atn->elementType) {
             outArrayDetails.elementType = astStandardTypeToSymbolType(atn->elementType);
         }
@@ -85,8 +99,10 @@ EntryTypeCategory SemanticAnalyzer::astToSymbolType(TypeNode* astTypeNode, Array
             outArrayDetails.elementType = EntryTypeCategory::UNKNOWN_TYPE;
         }
         if (atn->startIndex && atn->endIndex) {
-            outArrayDetails.lowBound = atn->startIndex->value;
-            outArrayDetails.highBound = atn->endIndex->value;
+            bool inRange = checkIntegerRange(*atn->startIndex);
+            inRange = checkIntegerRange(*atn->endIndex) && inRange;
+            outArrayDetails.lowBound = inRange ? static_cast<int>(atn->startIndex->value) : 0;
+            outArrayDetails.highBound = inRange ? static_cast<int>(atn->endIndex->value) : 0;
             outArrayDetails.isInitialized = true;
             if (outArrayDetails.lowBound > outArrayDetails.highBound) {
                 recordError("For array type, lower bound (" + std::to_string(outArrayDetails.lowBound) +
@@ -109,7 +125,7 @@ bool SemanticAnalyzer::isPrintableType(EntryTypeCategory type, ExprNode* argNode
         type == EntryTypeCategory::PRIMITIVE_BOOLEAN) {
         return true;
     }
-    if (dynamic_cast<StringLiteralNode*>(argNode)) {
+    if (isa<StringLiteralNode>(argNode)) {
         return true;
     }
     return false;
@@ -164,7 +180,7 @@ void SemanticAnalyzer::visit(VarDecl& node) {
         }
 
         if (!symbolTable.addSymbol(entry)) {
-            SymbolEntry* existing = symbolTable.lookupSymbolInCurrentScope(identNode->name);
+            SymbolEntry* existing = symbolTable.lookupSymbolInCurrentScope(identNode->id);
             std::string conflictMsg = existing ? " Conflicts with existing " + symbolKindToString(existing->kind) + " declared at L:" + std::to_string(existing->declLine) : "";
             recordError("Identifier '" + identNode->name + "' re-declared in the current scope." + conflictMsg, identNode->line, identNode->column);
         }
@@ -191,11 +207,12 @@ void SemanticAnalyzer::visit(SubprogramDeclarations& node) {
 // MODIFIED: This now correctly finds the symbol entry for the current subprogram
 // and uses it to analyze the body, especially for RETURN statements.
 void SemanticAnalyzer::visit(SubprogramDeclaration& node) {
+    TraceScope span("SemanticAnalyzer::SubprogramDeclaration", "sema", node.head && node.head->name ? node.head->name->name : std::string());
     // Find the entry for the subprogram header, which was added in the first pass.
     SymbolEntry* entry = nullptr;
     if (node.head) {
         std::string mangledKey = "p_";
-        if (dynamic_cast<FunctionHeadNode*>(node.head)) mangledKey = "f_";
+        if (isa<FunctionHeadNode>(node.head)) mangledKey = "f_";
         mangledKey += node.head->name->name;
 
         // This is a simplified way to reconstruct the mangled name from declaration
@@ -229,7 +246,7 @@ void SemanticAnalyzer::visit(SubprogramDeclaration& node) {
     param_offset = 0;
 
     FunctionHeadNode* previousFunctionContext = currentFunctionContext;
-    if (auto funcHead = dynamic_cast<FunctionHeadNode*>(node.head)) {
+    if (auto funcHead = dyn_cast<FunctionHeadNode>(node.head)) {
         currentFunctionContext = funcHead;
     }
     else {
@@ -323,7 +340,7 @@ void SemanticAnalyzer::visit(ParameterDeclaration& node) {
         }
 
         if (!symbolTable.addSymbol(entry)) { // Add to the current (subprogram's) scope
-            SymbolEntry* existing = symbolTable.lookupSymbolInCurrentScope(identNode->name);
+            SymbolEntry* existing = symbolTable.lookupSymbolInCurrentScope(identNode->id);
             std::string conflictMsg = existing ? " Conflicts with existing " + symbolKindToString(existing->kind) + " declared at L:" + std::to_string(existing->declLine) : "";
             recordError("Parameter '" + identNode->name + "' re-declared in this scope." + conflictMsg, identNode->line, identNode->column);
         }
@@ -336,13 +353,55 @@ void SemanticAnalyzer::visit(ParameterList& node) {
     }
 }
 
-void SemanticAnalyzer::visit(CompoundStatementNode& node) {
-    if (node.stmts) node.stmts->accept(*this);
-}
-
-void SemanticAnalyzer::visit(StatementList& node) {
-    for (StatementNode* stmt : node.statements) {
-        if (stmt) stmt->accept(*this);
+// --- Statements and Expressions ---
+// These nest as deep as the source does, so they are analyzed on the AstWalker
+// stack: visit() starts a walk and resume() steps through each node, in the
+// same order and with the same diagnostics as a recursive visit would.
+
+void SemanticAnalyzer::visit(CompoundStatementNode& node) { walk(&node); }
+void SemanticAnalyzer::visit(StatementList& node) { walk(&node); }
+void SemanticAnalyzer::visit(AssignStatementNode& node) { walk(&node); }
+void SemanticAnalyzer::visit(IfStatementNode& node) { walk(&node); }
+void SemanticAnalyzer::visit(WhileStatementNode& node) { walk(&node); }
+void SemanticAnalyzer::visit(VariableNode& node) { walk(&node); }
+void SemanticAnalyzer::visit(ProcedureCallStatementNode& node) { walk(&node); }
+void SemanticAnalyzer::visit(ExpressionList& node) { walk(&node); }
+void SemanticAnalyzer::visit(BinaryOpNode& node) { walk(&node); }
+void SemanticAnalyzer::visit(UnaryOpNode& node) { walk(&node); }
+void SemanticAnalyzer::visit(FunctionCallExprNode& node) { walk(&node); }
+void SemanticAnalyzer::visit(ReturnStatementNode& node) { walk(&node); }
+
+Node* SemanticAnalyzer::resume(Frame& frame) {
+    Node* node = frame.node;
+    switch (node->getKind()) {
+    case NodeKind::COMPOUND_STATEMENT:
+        return frame.step++ == 0 ? cast<CompoundStatementNode>(node)->stmts : nullptr;
+    case NodeKind::STATEMENT_LIST:
+        return nextElement(cast<StatementList>(node)->statements, frame);
+    case NodeKind::EXPRESSION_LIST:
+        return nextElement(cast<ExpressionList>(node)->expressions, frame);
+    case NodeKind::ASSIGN_STATEMENT:
+        return resumeAssign(*cast<AssignStatementNode>(node), frame);
+    case NodeKind::IF_STATEMENT:
+        return resumeIf(*cast<IfStatementNode>(node), frame);
+    case NodeKind::WHILE_STATEMENT:
+        return resumeWhile(*cast<WhileStatementNode>(node), frame);
+    case NodeKind::VARIABLE:
+        return resumeVariable(*cast<VariableNode>(node), frame);
+    case NodeKind::PROCEDURE_CALL:
+        return resumeProcedureCall(*cast<ProcedureCallStatementNode>(node), frame);
+    case NodeKind::BINARY_OP:
+        return resumeBinaryOp(*cast<BinaryOpNode>(node), frame);
+    case NodeKind::UNARY_OP:
+        return resumeUnaryOp(*cast<UnaryOpNode>(node), frame);
+    case NodeKind::FUNCTION_CALL:
+        return resumeFunctionCall(*cast<FunctionCallExprNode>(node), frame);
+    case NodeKind::RETURN_STATEMENT:
+        return resumeReturn(*cast<ReturnStatementNode>(node), frame);
+    default:
+        // Identifiers and literals: nothing below them to walk
+        node->accept(*this);
+        return nullptr;
     }
 }
 
@@ -351,21 +410,26 @@ void SemanticAnalyzer::visit(IdentNode& node) { /* Not typically visited directl
 void SemanticAnalyzer::visit(StandardTypeNode& node) { /* Processed by parent */ }
 void SemanticAnalyzer::visit(ArrayTypeNode& node) { /* Processed by parent */ }
 
-void SemanticAnalyzer::visit(AssignStatementNode& node) {
-    if (!node.variable || !node.expression) {
-        recordError("Malformed assignment statement (missing variable or expression).", node.line, node.column);
-        return;
+Node* SemanticAnalyzer::resumeAssign(AssignStatementNode& node, Frame& frame) {
+    switch (frame.step) {
+    case 0:
+        if (!node.variable || !node.expression) {
+            recordError("Malformed assignment statement (missing variable or expression).", node.line, node.column);
+            return nullptr;
+        }
+        frame.step = 1;
+        return node.variable;
+    case 1:
+        frame.step = 2;
+        return node.expression;
     }
 
-    node.variable->accept(*this);
-    node.expression->accept(*this);
-
     EntryTypeCategory lhsType = node.variable->determinedType;
     EntryTypeCategory rhsType = node.expression->determinedType;
 
     if (lhsType == EntryTypeCategory::UNKNOWN_TYPE || rhsType == EntryTypeCategory::UNKNOWN_TYPE) {
         // An error was already recorded for the variable or expression.
-        return;
+        return nullptr;
     }
 
     bool compatible = false;
@@ -393,60 +457,81 @@ void SemanticAnalyzer::visit(AssignStatementNode& node) {
             " to variable of type " + entryTypeToString(lhsType) + ".",
             node.line, node.column);
     }
+    return nullptr;
 }
 
-void SemanticAnalyzer::visit(IfStatementNode& node) {
-    if (node.condition) {
-        node.condition->accept(*this);
-        if (node.condition->determinedType != EntryTypeCategory::PRIMITIVE_BOOLEAN &&
+Node* SemanticAnalyzer::resumeIf(IfStatementNode& node, Frame& frame) {
+    switch (frame.step) {
+    case 0:
+        frame.step = 1;
+        if (node.condition) return node.condition;
+        recordError("IF statement missing condition.", node.line, node.column);
+        [[fallthrough]];
+    case 1:
+        if (node.condition &&
+            node.condition->determinedType != EntryTypeCategory::PRIMITIVE_BOOLEAN &&
             node.condition->determinedType != EntryTypeCategory::UNKNOWN_TYPE) { // Avoid cascading errors
             recordError("IF condition expression evaluated to " + entryTypeToString(node.condition->determinedType) +
                 ", but BOOLEAN was expected.", node.condition->line, node.condition->column);
         }
+        frame.step = 2;
+        if (node.thenStatement) return node.thenStatement;
+        [[fallthrough]];
+    case 2:
+        frame.step = 3;
+        return node.elseStatement;
     }
-    else {
-        recordError("IF statement missing condition.", node.line, node.column);
-    }
-    if (node.thenStatement) node.thenStatement->accept(*this);
-    if (node.elseStatement) node.elseStatement->accept(*this);
+    return nullptr;
 }
 
-void SemanticAnalyzer::visit(WhileStatementNode& node) {
-    if (node.condition) {
-        node.condition->accept(*this);
-        if (node.condition->determinedType != EntryTypeCategory::PRIMITIVE_BOOLEAN &&
+Node* SemanticAnalyzer::resumeWhile(WhileStatementNode& node, Frame& frame) {
+    switch (frame.step) {
+    case 0:
+        frame.step = 1;
+        if (node.condition) return node.condition;
+        recordError("WHILE statement missing condition.", node.line, node.column);
+        [[fallthrough]];
+    case 1:
+        if (node.condition &&
+            node.condition->determinedType != EntryTypeCategory::PRIMITIVE_BOOLEAN &&
             node.condition->determinedType != EntryTypeCategory::UNKNOWN_TYPE) { // Avoid cascading errors
             recordError("WHILE condition expression evaluated to " + entryTypeToString(node.condition->determinedType) +
                 ", but BOOLEAN was expected.", node.condition->line, node.condition->column);
         }
-    }
-    else {
-        recordError("WHILE statement missing condition.", node.line, node.column);
-    }
-    if (node.body) node.body->accept(*this);
-    else {
+        frame.step = 2;
+        if (node.body) return node.body;
         recordError("WHILE statement missing body.", node.line, node.column);
     }
+    return nullptr;
 }
 
-void SemanticAnalyzer::visit(VariableNode& node) {
+Node* SemanticAnalyzer::resumeVariable(VariableNode& node, Frame& frame) {
+    if (frame.step == 1) { // back from the index expression
+        if (node.index->determinedType != EntryTypeCategory::PRIMITIVE_INTEGER &&
+            node.index->determinedType != EntryTypeCategory::UNKNOWN_TYPE) {
+            recordError("Array index for '" + node.identifier->name + "' must be an INTEGER expression, but found " +
+                entryTypeToString(node.index->determinedType) + ".", node.index->line, node.index->column);
+        }
+        return nullptr;
+    }
+
     if (!node.identifier) {
         node.determinedType = EntryTypeCategory::UNKNOWN_TYPE;
         recordError("Internal: VariableNode has no identifier.", node.line, node.column);
-        return;
+        return nullptr;
     }
-    SymbolEntry* entry = symbolTable.lookupSymbol(node.identifier->name);
+    SymbolEntry* entry = symbolTable.lookupSymbol(node.identifier->id);
     if (!entry) {
         recordError("Identifier '" + node.identifier->name + "' is not declared.", node.identifier->line, node.identifier->column);
         node.determinedType = EntryTypeCategory::UNKNOWN_TYPE;
-        return;
+        return nullptr;
     }
 
     node.offset = entry->offset;
     node.kind = entry->kind;
     if (entry->kind == SymbolKind::VARIABLE || entry->kind == SymbolKind::PARAMETER) {
         if (symbolTable.getCurrentLevel() > 0) { // Inside a subprogram
-            SymbolEntry* current_scope_check = symbolTable.lookupSymbolInCurrentScope(node.identifier->name);
+            SymbolEntry* current_scope_check = symbolTable.lookupSymbolInCurrentScope(node.identifier->id);
             if (current_scope_check) {
                 node.scope = SymbolScope::LOCAL;
             }
@@ -466,7 +551,7 @@ void SemanticAnalyzer::visit(VariableNode& node) {
     if (entry->kind != SymbolKind::VARIABLE && entry->kind != SymbolKind::PARAMETER) {
         recordError("Identifier '" + node.identifier->name + "' (" + symbolKindToString(entry->kind) + ") cannot be used as a variable here.", node.identifier->line, node.identifier->column);
         node.determinedType = EntryTypeCategory::UNKNOWN_TYPE;
-        return;
+        return nullptr;
     }
 
     if (node.index != nullptr) { // Array element access
@@ -474,16 +559,12 @@ void SemanticAnalyzer::visit(VariableNode& node) {
             recordError("Identifier '" + node.identifier->name + "' is of type " + entryTypeToString(entry->type) +
                 " and cannot be indexed as an array.", node.identifier->line, node.identifier->column);
             node.determinedType = EntryTypeCategory::UNKNOWN_TYPE;
-            return;
-        }
-        node.index->accept(*this);
-        if (node.index->determinedType != EntryTypeCategory::PRIMITIVE_INTEGER &&
-            node.index->determinedType != EntryTypeCategory::UNKNOWN_TYPE) {
-            recordError("Array index for '" + node.identifier->name + "' must be an INTEGER expression, but found " +
-                entryTypeToString(node.index->determinedType) + ".", node.index->line, node.index->column);
+            return nullptr;
         }
         node.determinedType = entry->arrayDetails.elementType;
         node.determinedArrayDetails.isInitialized = false; // This is an an element, not a whole array
+        frame.step = 1;
+        return node.index;
     }
     else { // Simple variable or whole array identifier
         node.determinedType = entry->type;
@@ -494,58 +575,57 @@ void SemanticAnalyzer::visit(VariableNode& node) {
             node.determinedArrayDetails.isInitialized = false;
         }
     }
+    return nullptr;
 }
 
-void SemanticAnalyzer::visit(ProcedureCallStatementNode& node) {
+Node* SemanticAnalyzer::resumeProcedureCall(ProcedureCallStatementNode& node, Frame& frame) {
     if (!node.procName) {
         recordError("Procedure call missing name.", node.line, node.column);
-        return;
+        return nullptr;
     }
     const std::string& procNameStr = node.procName->name;
-
-    // Handle built-in procedures as special cases
-    if (procNameStr == "write" || procNameStr == "writeln") {
-        if (node.arguments) {
-            for (ExprNode* argExpr : node.arguments->expressions) {
-                if (argExpr) {
-                    argExpr->accept(*this);
-                    if (!isPrintableType(argExpr->determinedType, argExpr)) {
-                        recordError("Argument type " + entryTypeToString(argExpr->determinedType) + " is not printable.", argExpr->line, argExpr->column);
-                    }
-                }
-            }
-        }
-        return;
-    }
-    if (procNameStr == "read" || procNameStr == "readln") {
-        if (!node.arguments || node.arguments->expressions.empty()) {
+    SymbolId procId = node.procName->id;
+
+    // Handle built-in procedures as special cases. Their arguments are
+    // checked one at a time: frame.scratch counts the ones looked at, and
+    // step 1 means the last of those was just analyzed.
+    bool writing = procId == SYM_WRITE || procId == SYM_WRITELN;
+    bool reading = procId == SYM_READ || procId == SYM_READLN;
+    if (writing || reading) {
+        if (frame.step == 0 && reading && (!node.arguments || node.arguments->expressions.empty())) {
             recordError("'" + procNameStr + "' requires at least one variable argument.", node.procName->line, node.procName->column);
+            return nullptr;
         }
-        else {
-            for (ExprNode* argExpr : node.arguments->expressions) {
-                if (argExpr) {
-                    auto* varArg = dynamic_cast<VariableNode*>(argExpr);
-                    auto* idArg = dynamic_cast<IdExprNode*>(argExpr);
-                    if (!varArg && !idArg) {
-                        recordError("Argument to '" + procNameStr + "' must be a variable.", argExpr->line, argExpr->column);
-                        continue;
-                    }
-                    argExpr->accept(*this);
-                    if (!isReadableType(argExpr->determinedType)) {
-                        recordError("Cannot read into variable of type " + entryTypeToString(argExpr->determinedType) + ".", argExpr->line, argExpr->column);
-                    }
-                    if (argExpr->determinedType == EntryTypeCategory::ARRAY) {
-                        recordError("Cannot read directly into an entire array.", argExpr->line, argExpr->column);
-                    }
-                }
+        if (frame.step == 1) {
+            ExprNode* argExpr = node.arguments->expressions[frame.scratch - 1];
+            if (writing && !isPrintableType(argExpr->determinedType, argExpr)) {
+                recordError("Argument type " + entryTypeToString(argExpr->determinedType) + " is not printable.", argExpr->line, argExpr->column);
+            }
+            if (reading && !isReadableType(argExpr->determinedType)) {
+                recordError("Cannot read into variable of type " + entryTypeToString(argExpr->determinedType) + ".", argExpr->line, argExpr->column);
+            }
+            if (reading && argExpr->determinedType == EntryTypeCategory::ARRAY) {
+                recordError("Cannot read directly into an entire array.", argExpr->line, argExpr->column);
             }
         }
-        return;
+        if (!node.arguments) return nullptr;
+        while (static_cast<size_t>(frame.scratch) < node.arguments->expressions.size()) {
+            ExprNode* argExpr = node.arguments->expressions[frame.scratch++];
+            if (!argExpr) continue;
+            if (reading && !isa<VariableNode>(argExpr) && !isa<IdExprNode>(argExpr)) {
+                recordError("Argument to '" + procNameStr + "' must be a variable.", argExpr->line, argExpr->column);
+                continue;
+            }
+            frame.step = 1;
+            return argExpr;
+        }
+        return nullptr;
     }
 
     // --- Overload Resolution for User-Defined Procedures ---
-    if (node.arguments) {
-        node.arguments->accept(*this);
+    if (frame.step == 0 && node.arguments) {
+        frame.step = 1;
+        return node.arguments;
     }
     std::string mangledKey = buildMangledName(procNameStr, SymbolKind::PROCEDURE, node.arguments);
     SymbolEntry* entry = symbolTable.lookupSymbol(mangledKey);
@@ -559,18 +639,14 @@ void SemanticAnalyzer::visit(ProcedureCallStatementNode& node) {
             }
         }
         recordError("No matching procedure '" + procNameStr + "' for arguments (" + argTypes + ").", node.procName->line, node.procName->column);
-        return;
+        return nullptr;
     }
     node.resolved_entry = entry;
-}
-
-void SemanticAnalyzer::visit(ExpressionList& node) {
-    for (ExprNode* expr : node.expressions) {
-        if (expr) expr->accept(*this);
-    }
+    return nullptr;
 }
 
 void SemanticAnalyzer::visit(IntNumNode& node) {
+    checkIntegerRange(node);
     node.determinedType = EntryTypeCategory::PRIMITIVE_INTEGER;
     node.determinedArrayDetails.isInitialized = false;
 }
@@ -587,119 +663,138 @@ void SemanticAnalyzer::visit(StringLiteralNode& node) {
     node.determinedArrayDetails.isInitialized = false;
 }
 
-void SemanticAnalyzer::visit(BinaryOpNode& node) {
-    node.determinedType = EntryTypeCategory::UNKNOWN_TYPE;
-    node.determinedArrayDetails.isInitialized = false;
+// --- Operator Type Rules ---
+
+// What a binary operator accepts on both sides
+enum class OperandRule { NUMERIC, INTEGER, BOOLEAN, EQUATABLE };
+
+struct BinaryTypeRule {
+    OperandRule operands;
+    EntryTypeCategory result;   // UNKNOWN_TYPE: the wider numeric operand type
+    bool relational;            // comparing arrays gets its own diagnostic
+    const char* description;    // "Operands for <description> '<name>' <requirement>."
+    const char* shownName;      // name in that message, if not binaryOperatorName()
+    const char* requirement;
+};
+
+// Indexed by BinaryOperator
+static const BinaryTypeRule binaryTypeRules[BINARY_OPERATOR_COUNT] = {
+    /* ADD      */ { OperandRule::NUMERIC,   EntryTypeCategory::UNKNOWN_TYPE,      false, "binary operator", nullptr, "must be numeric" },
+    /* SUB      */ { OperandRule::NUMERIC,   EntryTypeCategory::UNKNOWN_TYPE,      false, "binary operator", nullptr, "must be numeric" },
+    /* MUL      */ { OperandRule::NUMERIC,   EntryTypeCategory::UNKNOWN_TYPE,      false, "binary operator", nullptr, "must be numeric" },
+    /* REAL_DIV */ { OperandRule::NUMERIC,   EntryTypeCategory::PRIMITIVE_REAL,    false, "real division operator", nullptr, "must be numeric" },
+    /* INT_DIV  */ { OperandRule::INTEGER,   EntryTypeCategory::PRIMITIVE_INTEGER, false, "integer division operator", "DIV", "must both be INTEGER" },
+    /* AND      */ { OperandRule::BOOLEAN,   EntryTypeCategory::PRIMITIVE_BOOLEAN, false, "logical operator", nullptr, "must both be BOOLEAN" },
+    /* OR       */ { OperandRule::BOOLEAN,   EntryTypeCategory::PRIMITIVE_BOOLEAN, false, "logical operator", nullptr, "must both be BOOLEAN" },
+    /* EQ       */ { OperandRule::EQUATABLE, EntryTypeCategory::PRIMITIVE_BOOLEAN, true,  "relational operator", nullptr, "are not compatible" },
+    /* NEQ      */ { OperandRule::EQUATABLE, EntryTypeCategory::PRIMITIVE_BOOLEAN, true,  "relational operator", nullptr, "are not compatible" },
+    /* LT       */ { OperandRule::NUMERIC,   EntryTypeCategory::PRIMITIVE_BOOLEAN, true,  "relational operator", nullptr, "are not compatible" },
+    /* LTE      */ { OperandRule::NUMERIC,   EntryTypeCategory::PRIMITIVE_BOOLEAN, true,  "relational operator", nullptr, "are not compatible" },
+    /* GT       */ { OperandRule::NUMERIC,   EntryTypeCategory::PRIMITIVE_BOOLEAN, true,  "relational operator", nullptr, "are not compatible" },
+    /* GTE      */ { OperandRule::NUMERIC,   EntryTypeCategory::PRIMITIVE_BOOLEAN, true,  "relational operator", nullptr, "are not compatible" },
+};
+
+static bool isNumericType(EntryTypeCategory type) {
+    return type == EntryTypeCategory::PRIMITIVE_INTEGER || type == EntryTypeCategory::PRIMITIVE_REAL;
+}
+
+Node* SemanticAnalyzer::resumeBinaryOp(BinaryOpNode& node, Frame& frame) {
+    switch (frame.step) {
+    case 0:
+        node.determinedType = EntryTypeCategory::UNKNOWN_TYPE;
+        node.determinedArrayDetails.isInitialized = false;
 
-    if (!node.left || !node.right) {
-        recordError("Binary operation missing operand(s).", node.line, node.column);
-        return;
+        if (!node.left || !node.right) {
+            recordError("Binary operation missing operand(s).", node.line, node.column);
+            return nullptr;
+        }
+        frame.step = 1;
+        return node.left;
+    case 1:
+        frame.step = 2;
+        return node.right;
     }
-    node.left->accept(*this);
-    node.right->accept(*this);
 
     EntryTypeCategory leftType = node.left->determinedType;
     EntryTypeCategory rightType = node.right->determinedType;
 
     if (leftType == EntryTypeCategory::UNKNOWN_TYPE || rightType == EntryTypeCategory::UNKNOWN_TYPE) {
-        return;
+        return nullptr;
+    }
+
+    const BinaryTypeRule& rule = binaryTypeRules[static_cast<size_t>(node.op)];
+    bool numeric = isNumericType(leftType) && isNumericType(rightType);
+    bool accepted = false;
+    switch (rule.operands) {
+    case OperandRule::NUMERIC: accepted = numeric; break;
+    case OperandRule::INTEGER: accepted = leftType == EntryTypeCategory::PRIMITIVE_INTEGER && rightType == EntryTypeCategory::PRIMITIVE_INTEGER; break;
+    case OperandRule::BOOLEAN: accepted = leftType == EntryTypeCategory::PRIMITIVE_BOOLEAN && rightType == EntryTypeCategory::PRIMITIVE_BOOLEAN; break;
+    case OperandRule::EQUATABLE: accepted = numeric || (leftType == EntryTypeCategory::PRIMITIVE_BOOLEAN && rightType == EntryTypeCategory::PRIMITIVE_BOOLEAN); break;
     }
 
-    const std::string& op = node.op;
-    if (op == "+" || op == "-" || op == "*") {
-        if ((leftType == EntryTypeCategory::PRIMITIVE_INTEGER || leftType == EntryTypeCategory::PRIMITIVE_REAL) &&
-            (rightType == EntryTypeCategory::PRIMITIVE_INTEGER || rightType == EntryTypeCategory::PRIMITIVE_REAL)) {
+    if (accepted) {
+        if (rule.result == EntryTypeCategory::UNKNOWN_TYPE) { // the wider of the two numeric operands
             node.determinedType = (leftType == EntryTypeCategory::PRIMITIVE_REAL || rightType == EntryTypeCategory::PRIMITIVE_REAL) ?
                 EntryTypeCategory::PRIMITIVE_REAL : EntryTypeCategory::PRIMITIVE_INTEGER;
         }
         else {
-            recordError("Operands for binary operator '" + op + "' must be numeric.", node.line, node.column);
-        }
-    }
-    else if (op == "/") {
-        if ((leftType == EntryTypeCategory::PRIMITIVE_INTEGER || leftType == EntryTypeCategory::PRIMITIVE_REAL) &&
-            (rightType == EntryTypeCategory::PRIMITIVE_INTEGER || rightType == EntryTypeCategory::PRIMITIVE_REAL)) {
-            node.determinedType = EntryTypeCategory::PRIMITIVE_REAL;
-        }
-        else {
-            recordError("Operands for real division operator '/' must be numeric.", node.line, node.column);
+            node.determinedType = rule.result;
         }
     }
-    else if (op == "DIV_OP") {
-        if (leftType == EntryTypeCategory::PRIMITIVE_INTEGER && rightType == EntryTypeCategory::PRIMITIVE_INTEGER) {
-            node.determinedType = EntryTypeCategory::PRIMITIVE_INTEGER;
-        }
-        else {
-            recordError("Operands for integer division operator 'DIV' must both be INTEGER.", node.line, node.column);
-        }
-    }
-    else if (op == "AND_OP" || op == "OR_OP") {
-        if (leftType == EntryTypeCategory::PRIMITIVE_BOOLEAN && rightType == EntryTypeCategory::PRIMITIVE_BOOLEAN) {
-            node.determinedType = EntryTypeCategory::PRIMITIVE_BOOLEAN;
-        }
-        else {
-            recordError("Operands for logical operator '" + op + "' must both be BOOLEAN.", node.line, node.column);
-        }
-    }
-    else if (op == "EQ_OP" || op == "NEQ_OP" || op == "LT_OP" || op == "LTE_OP" || op == "GT_OP" || op == "GTE_OP") {
-        bool compatible = false;
-        if ((leftType == EntryTypeCategory::PRIMITIVE_INTEGER || leftType == EntryTypeCategory::PRIMITIVE_REAL) &&
-            (rightType == EntryTypeCategory::PRIMITIVE_INTEGER || rightType == EntryTypeCategory::PRIMITIVE_REAL)) {
-            compatible = true;
-        }
-        else if (leftType == EntryTypeCategory::PRIMITIVE_BOOLEAN && rightType == EntryTypeCategory::PRIMITIVE_BOOLEAN && (op == "EQ_OP" || op == "NEQ_OP")) {
-            compatible = true;
-        }
-        else if (leftType == EntryTypeCategory::ARRAY || rightType == EntryTypeCategory::ARRAY) {
-            recordError("Cannot directly compare arrays with operator '" + op + "'.", node.line, node.column);
-        }
-
-        if (compatible) {
-            node.determinedType = EntryTypeCategory::PRIMITIVE_BOOLEAN;
-        }
-        else if (!(leftType == EntryTypeCategory::ARRAY || rightType == EntryTypeCategory::ARRAY)) {
-            recordError("Operands for relational operator '" + op + "' are not compatible.", node.line, node.column);
-        }
+    else if (rule.relational && (leftType == EntryTypeCategory::ARRAY || rightType == EntryTypeCategory::ARRAY)) {
+        recordError("Cannot directly compare arrays with operator '" + std::string(binaryOperatorName(node.op)) + "'.", node.line, node.column);
     }
     else {
-        recordError("Internal: Unknown binary operator '" + op + "'.", node.line, node.column);
+        const char* shownName = rule.shownName ? rule.shownName : binaryOperatorName(node.op);
+        recordError(std::string("Operands for ") + rule.description + " '" + shownName + "' " + rule.requirement + ".", node.line, node.column);
     }
+    return nullptr;
 }
 
-void SemanticAnalyzer::visit(UnaryOpNode& node) {
-    node.determinedType = EntryTypeCategory::UNKNOWN_TYPE;
-    node.determinedArrayDetails.isInitialized = false;
+Node* SemanticAnalyzer::resumeUnaryOp(UnaryOpNode& node, Frame& frame) {
+    if (frame.step == 0) {
+        node.determinedType = EntryTypeCategory::UNKNOWN_TYPE;
+        node.determinedArrayDetails.isInitialized = false;
 
-    if (!node.expression) {
-        recordError("Unary operation missing operand.", node.line, node.column);
-        return;
+        if (!node.expression) {
+            recordError("Unary operation missing operand.", node.line, node.column);
+            return nullptr;
+        }
+        frame.step = 1;
+        IntNumNode* literal = node.op == UnaryOperator::NEG ? dyn_cast<IntNumNode>(node.expression) : nullptr;
+        if (!literal) return node.expression;
+        // A negated literal is typed here rather than visited, so its range
+        // check sees the minus sign.
+        checkIntegerRange(*literal, true);
+        literal->determinedType = EntryTypeCategory::PRIMITIVE_INTEGER;
+        literal->determinedArrayDetails.isInitialized = false;
     }
-    node.expression->accept(*this);
+
     EntryTypeCategory operandType = node.expression->determinedType;
 
     if (operandType == EntryTypeCategory::UNKNOWN_TYPE) {
-        return;
+        return nullptr;
     }
 
-    if (node.op == "-") {
-        if (operandType == EntryTypeCategory::PRIMITIVE_INTEGER || operandType == EntryTypeCategory::PRIMITIVE_REAL) {
+    switch (node.op) {
+    case UnaryOperator::NEG:
+        if (isNumericType(operandType)) {
             node.determinedType = operandType;
         }
         else {
             recordError("Operand for unary '-' operator must be numeric.", node.expression->line, node.expression->column);
         }
-    }
-    else if (node.op == "NOT_OP") {
+        break;
+    case UnaryOperator::NOT:
         if (operandType == EntryTypeCategory::PRIMITIVE_BOOLEAN) {
             node.determinedType = EntryTypeCategory::PRIMITIVE_BOOLEAN;
         }
         else {
             recordError("Operand for 'NOT' operator must be BOOLEAN.", node.expression->line, node.expression->column);
         }
+        break;
     }
-    else {
-        recordError("Internal: Unknown unary operator '" + node.op + "'.", node.line, node.column);
-    }
+    return nullptr;
 }
 
 // MODIFIED: Logic to handle ambiguity between variables and parameter-less functions.
@@ -713,7 +808,7 @@ void SemanticAnalyzer::visit(IdExprNode& node) {
     }
 
     // First, check if it's a variable or parameter using its simple name.
-    SymbolEntry* entry = symbolTable.lookupSymbol(node.ident->name);
+    SymbolEntry* entry = symbolTable.lookupSymbol(node.ident->id);
     if (entry && (entry->kind == SymbolKind::VARIABLE || entry->kind == SymbolKind::PARAMETER)) {
         node.offset = entry->offset;
         node.kind = entry->kind;
@@ -722,7 +817,7 @@ void SemanticAnalyzer::visit(IdExprNode& node) {
             node.determinedArrayDetails = entry->arrayDetails;
         }
         if (symbolTable.getCurrentLevel() > 0) {
-            node.scope = symbolTable.lookupSymbolInCurrentScope(node.ident->name) ? SymbolScope::LOCAL : SymbolScope::GLOBAL;
+            node.scope = symbolTable.lookupSymbolInCurrentScope(node.ident->id) ? SymbolScope::LOCAL : SymbolScope::GLOBAL;
         }
         else {
             node.scope = SymbolScope::GLOBAL;
@@ -752,15 +847,16 @@ void SemanticAnalyzer::visit(IdExprNode& node) {
 }
 
 // MODIFIED: Complete rewrite for Overload Resolution
-void SemanticAnalyzer::visit(FunctionCallExprNode& node) {
-    node.determinedType = EntryTypeCategory::UNKNOWN_TYPE;
-    if (!node.funcName) {
-        recordError("Function call is missing a name.", node.line, node.column);
-        return;
-    }
+Node* SemanticAnalyzer::resumeFunctionCall(FunctionCallExprNode& node, Frame& frame) {
+    if (frame.step == 0) {
+        node.determinedType = EntryTypeCategory::UNKNOWN_TYPE;
+        if (!node.funcName) {
+            recordError("Function call is missing a name.", node.line, node.column);
+            return nullptr;
+        }
 
-    if (node.arguments) {
-        node.arguments->accept(*this);
+        frame.step = 1;
+        if (node.arguments) return node.arguments;
     }
 
     std::string mangledKey = buildMangledName(node.funcName->name, SymbolKind::FUNCTION, node.arguments);
@@ -775,7 +871,7 @@ void SemanticAnalyzer::visit(FunctionCallExprNode& node) {
             }
         }
         recordError("No matching function named '" + node.funcName->name + "' with arguments (" + argTypes + ") was found.", node.funcName->line, node.funcName->column);
-        return;
+        return nullptr;
     }
 
     node.resolved_entry = entry;
@@ -791,25 +887,29 @@ void SemanticAnalyzer::visit(FunctionCallExprNode& node) {
             }
         }
     }
+    return nullptr;
 }
 
 
-void SemanticAnalyzer::visit(ReturnStatementNode& node) {
-    if (!currentSubprogramEntry) {
-        recordError("RETURN statement found outside of a function.", node.line, node.column);
-        return;
-    }
-    if (currentSubprogramEntry->kind != SymbolKind::FUNCTION) {
-        recordError("RETURN statement can only be used inside a function.", node.line, node.column);
-        return;
-    }
+Node* SemanticAnalyzer::resumeReturn(ReturnStatementNode& node, Frame& frame) {
+    if (frame.step == 0) {
+        frame.step = 1;
+        if (!currentSubprogramEntry) {
+            recordError("RETURN statement found outside of a function.", node.line, node.column);
+            return nullptr;
+        }
+        if (currentSubprogramEntry->kind != SymbolKind::FUNCTION) {
+            recordError("RETURN statement can only be used inside a function.", node.line, node.column);
+            return nullptr;
+        }
 
-    if (!node.returnValue) {
-        recordError("RETURN statement in function '" + currentSubprogramEntry->name + "' must have a return value.", node.line, node.column);
-        return;
+        if (!node.returnValue) {
+            recordError("RETURN statement in function '" + currentSubprogramEntry->name + "' must have a return value.", node.line, node.column);
+            return nullptr;
+        }
+        return node.returnValue;
     }
 
-    node.returnValue->accept(*this);
     EntryTypeCategory actualReturnType = node.returnValue->determinedType;
     EntryTypeCategory expectedReturnType = currentSubprogramEntry->functionReturnType;
 
@@ -822,4 +922,5 @@ void SemanticAnalyzer::visit(ReturnStatementNode& node) {
             " but got " + entryTypeToString(actualReturnType) + ".",
             node.returnValue->line, node.returnValue->column);
     }
+    return nullptr;
 }
\ No newline at end of file
@@ -3,12 +3,14 @@
 
 #include "semantic_visitor.h"
 #include "symbol_table.h" 
+#include "interner.h"
 #include "ast.h"          
+#include "ast_walker.h"
 #include <vector>
 #include <string>
 #include <iostream>
 
-class SemanticAnalyzer : public SemanticVisitor {
+class SemanticAnalyzer : public SemanticVisitor, private AstWalker {
 private:
     SymbolTable symbolTable;
     FunctionHeadNode* currentFunctionContext;
@@ -19,6 +21,9 @@ private:
     int param_offset = 0;
 
     void recordError(const std::string& message, int line, int col);
+    // Records an error unless the literal, or its negation if 'negated', fits
+    // in 'integer'
+    bool checkIntegerRange(const IntNumNode& literal, bool negated = false);
     EntryTypeCategory astToSymbolType(TypeNode* astTypeNode, ArrayDetails& outArrayDetails);
     EntryTypeCategory astStandardTypeToSymbolType(StandardTypeNode* astStandardTypeNode);
 
@@ -27,8 +32,20 @@ private:
 
     std::string buildMangledName(const std::string& name, SymbolKind kind, ExpressionList* args);
 
+    // Statements and expressions, one step at a time (see AstWalker)
+    Node* resume(Frame& frame) override;
+    Node* resumeAssign(AssignStatementNode& node, Frame& frame);
+    Node* resumeIf(IfStatementNode& node, Frame& frame);
+    Node* resumeWhile(WhileStatementNode& node, Frame& frame);
+    Node* resumeVariable(VariableNode& node, Frame& frame);
+    Node* resumeProcedureCall(ProcedureCallStatementNode& node, Frame& frame);
+    Node* resumeBinaryOp(BinaryOpNode& node, Frame& frame);
+    Node* resumeUnaryOp(UnaryOpNode& node, Frame& frame);
+    Node* resumeFunctionCall(FunctionCallExprNode& node, Frame& frame);
+    Node* resumeReturn(ReturnStatementNode& node, Frame& frame);
+
 public:
-    SemanticAnalyzer();
+    explicit SemanticAnalyzer(StringInterner& names);
     SymbolTable& getSymbolTable() { return symbolTable; }
 
     // Visitor overrides
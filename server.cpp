@@ -0,0 +1,372 @@
+#include "server.h"
+#include "transcript.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <utility>
+
+#ifndef _WIN32
+
+#include "thread_pool.h"
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Requests larger than this are refused rather than buffered.
+static const size_t MAX_SOURCE_SIZE = 64 * 1024 * 1024;
+
+// A client that sends or takes nothing for this long is dropped, so it can't
+// hold on to a worker (or hold up SHUTDOWN, which waits for the workers).
+static const int CLIENT_TIMEOUT_SECONDS = 10;
+
+// --- Socket helpers ---
+
+// A connected socket with a small read buffer for the line-based headers.
+class Connection {
+private:
+    int fd;
+    std::string pending;
+
+    bool fill() {
+        char chunk[4096];
+        ssize_t n;
+        do {
+            n = ::read(fd, chunk, sizeof chunk);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) return false;
+        pending.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+public:
+    explicit Connection(int socket_fd) : fd(socket_fd) {}
+    ~Connection() { if (fd >= 0) ::close(fd); }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    // Reads up to the next '\n' (not included); false on EOF before it.
+    bool readLine(std::string& line) {
+        size_t newline;
+        while ((newline = pending.find('\n')) == std::string::npos) {
+            if (pending.size() > 64 * 1024 || !fill()) return false;
+        }
+        line = pending.substr(0, newline);
+        pending.erase(0, newline + 1);
+        return true;
+    }
+
+    bool readBytes(size_t count, std::string& bytes) {
+        while (pending.size() < count) {
+            if (!fill()) return false;
+        }
+        bytes = pending.substr(0, count);
+        pending.erase(0, count);
+        return true;
+    }
+
+    bool writeAll(const std::string& data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            written += static_cast<size_t>(n);
+        }
+        return true;
+    }
+};
+
+static bool fillAddress(const std::string& socket_path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof address.sun_path) {
+        std::cerr << "Error: Socket path too long: " << socket_path << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+    return true;
+}
+
+static int connectTo(const std::string& socket_path) {
+    sockaddr_un address;
+    if (!fillAddress(socket_path, address)) return -1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Makes reads and writes on 'fd' fail once they have waited 'seconds'.
+static void setTimeouts(int fd, int seconds) {
+    timeval limit = {};
+    limit.tv_sec = seconds;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof limit);
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof limit);
+}
+
+// Parses "<keyword> <number>" headers such as "SOURCE 120".
+static bool parseSizeHeader(const std::string& line, const std::string& keyword, size_t& size) {
+    if (line.rfind(keyword + " ", 0) != 0) return false;
+    std::istringstream in(line.substr(keyword.size() + 1));
+    return static_cast<bool>(in >> size);
+}
+
+// --- Server side ---
+
+static std::string compileRequest(const std::string& name, const std::string& output_dir, unsigned emit,
+    ScannerKind scanner, CacheDirectory* cache, const std::string& source) {
+    Transcript transcript;
+    TranscriptBuf log_buf(transcript, false);
+    TranscriptBuf diagnostics_buf(transcript, true);
+    std::ostream log(&log_buf);
+    std::ostream diagnostics(&diagnostics_buf);
+
+    CompilationContext ctx;
+    ctx.input_filename = name;
+    ctx.base_name = get_base_filename(name);
+    ctx.output_dir = output_dir;
+    ctx.emit = emit;
+    ctx.scanner = scanner;
+    ctx.cache = cache;
+    ctx.out = &log;
+    ctx.err = &diagnostics;
+
+    MemoryArtifactStore artifacts(ctx.output_dir, ctx.base_name);
+    CompileStatus status = compileSource(ctx, source, artifacts);
+
+    std::string response = "STATUS " + std::to_string(static_cast<int>(status)) + "\n";
+    for (const auto& chunk : transcript) {
+        response += (chunk.first ? "DIAGNOSTICS " : "LOG ") + std::to_string(chunk.second.size()) + "\n";
+        response += chunk.second;
+    }
+    for (const auto& artifact : artifacts.release()) {
+        response += "ARTIFACT " + artifact.first + " " + std::to_string(artifact.second.size()) + "\n";
+        response += artifact.second;
+    }
+    response += "END\n";
+    return response;
+}
+
+// Handles one request; returns true if it asked the server to shut down.
+static bool serveConnection(Connection& connection, CacheDirectory* cache) {
+    std::string line;
+    if (!connection.readLine(line)) return false;
+    if (line == "SHUTDOWN") {
+        connection.writeAll("END\n");
+        return true;
+    }
+    if (line != "COMPILE") {
+        connection.writeAll("ERROR Unknown request '" + line + "'\n");
+        return false;
+    }
+
+    std::string name = "input.pas";
+    std::string output_dir = "output";
+    unsigned emit = EMIT_ASM;
+    ScannerKind scanner = SCANNER_FLEX;
+    while (connection.readLine(line)) {
+        size_t size;
+        if (line.rfind("NAME ", 0) == 0) {
+            name = line.substr(5);
+        }
+        else if (line.rfind("OPTION output_dir=", 0) == 0) {
+            output_dir = line.substr(18);
+        }
+        else if (line.rfind("OPTION emit=", 0) == 0) {
+            if (!parseEmitList(line.substr(12), emit)) {
+                connection.writeAll("ERROR Bad emit list '" + line.substr(12) + "'\n");
+                return false;
+            }
+        }
+        else if (line.rfind("OPTION scanner=", 0) == 0) {
+            if (!parseScannerName(line.substr(15), scanner)) {
+                connection.writeAll("ERROR Bad scanner '" + line.substr(15) + "'\n");
+                return false;
+            }
+        }
+        else if (line.rfind("OPTION ", 0) == 0) {
+            connection.writeAll("ERROR Unknown option '" + line.substr(7) + "'\n");
+            return false;
+        }
+        else if (parseSizeHeader(line, "SOURCE", size)) {
+            std::string source;
+            if (size > MAX_SOURCE_SIZE) {
+                connection.writeAll("ERROR Source too large\n");
+            }
+            else if (connection.readBytes(size, source)) {
+                connection.writeAll(compileRequest(name, output_dir, emit, scanner, cache, source));
+            }
+            return false;
+        }
+        else {
+            connection.writeAll("ERROR Malformed header '" + line + "'\n");
+            return false;
+        }
+    }
+    return false;
+}
+
+int runServer(const std::string& socket_path, unsigned jobs, CacheDirectory* cache) {
+    // A client hanging up mid-response must not kill the server.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address;
+    if (!fillAddress(socket_path, address)) return 1;
+    int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "Error: Could not create socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    // A socket file left behind by a previous server would make bind() fail.
+    ::unlink(socket_path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0
+        || ::listen(listen_fd, SOMAXCONN) != 0) {
+        std::cerr << "Error: Could not listen on " << socket_path << ": " << std::strerror(errno) << std::endl;
+        ::close(listen_fd);
+        return 1;
+    }
+    std::cout << "Compile server listening on " << socket_path << std::endl;
+
+    std::atomic<bool> stopping(false);
+    {
+        WorkStealingPool pool(jobs);
+        while (!stopping) {
+            int client_fd = ::accept(listen_fd, nullptr, nullptr);
+            if (client_fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                break; // listen_fd was shut down by a SHUTDOWN request
+            }
+            setTimeouts(client_fd, CLIENT_TIMEOUT_SECONDS);
+            pool.submit([client_fd, listen_fd, &stopping, cache] {
+                Connection connection(client_fd);
+                if (serveConnection(connection, cache) && !stopping.exchange(true)) {
+                    ::shutdown(listen_fd, SHUT_RDWR); // wakes the accept() above
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    ::close(listen_fd);
+    ::unlink(socket_path.c_str());
+    std::cout << "Compile server stopped." << std::endl;
+    return 0;
+}
+
+// --- Client side ---
+
+CompileStatus compileRemote(const std::string& socket_path, CompilationContext& ctx) {
+    std::ifstream input(ctx.input_filename, std::ios::binary);
+    if (!input) {
+        *ctx.err << "Error: Could not open file " << ctx.input_filename << std::endl;
+        return CompileStatus::IO_ERROR;
+    }
+    std::ostringstream source;
+    source << input.rdbuf();
+
+    int fd = connectTo(socket_path);
+    if (fd < 0) {
+        *ctx.err << "Error: Could not connect to compile server at " << socket_path << std::endl;
+        return CompileStatus::IO_ERROR;
+    }
+    Connection connection(fd);
+
+    std::string request = "COMPILE\nNAME " + ctx.input_filename + "\n";
+    request += "OPTION output_dir=" + ctx.output_dir + "\n";
+    request += "OPTION emit=" + emitListToString(ctx.emit) + "\n";
+    request += std::string("OPTION scanner=") + scannerName(ctx.scanner) + "\n";
+    request += "SOURCE " + std::to_string(source.str().size()) + "\n";
+    request += source.str();
+    if (!connection.writeAll(request)) {
+        *ctx.err << "Error: Lost connection to compile server." << std::endl;
+        return CompileStatus::IO_ERROR;
+    }
+
+    std::string line;
+    if (!connection.readLine(line) || line.rfind("STATUS ", 0) != 0) {
+        if (line.rfind("ERROR ", 0) == 0) {
+            *ctx.err << "Compile server error: " << line.substr(6) << std::endl;
+        }
+        else {
+            *ctx.err << "Error: Bad response from compile server." << std::endl;
+        }
+        return CompileStatus::IO_ERROR;
+    }
+    int status_code = std::atoi(line.c_str() + 7);
+    if (status_code < 0 || status_code > static_cast<int>(CompileStatus::CODEGEN_ERROR)) {
+        *ctx.err << "Error: Bad response from compile server." << std::endl;
+        return CompileStatus::IO_ERROR;
+    }
+
+    FileArtifactStore artifacts(ctx.output_dir, ctx.base_name);
+    while (connection.readLine(line) && line != "END") {
+        size_t size;
+        std::string payload;
+        if (parseSizeHeader(line, "LOG", size) && connection.readBytes(size, payload)) {
+            *ctx.out << payload << std::flush;
+        }
+        else if (parseSizeHeader(line, "DIAGNOSTICS", size) && connection.readBytes(size, payload)) {
+            *ctx.err << payload << std::flush;
+        }
+        else if (line.rfind("ARTIFACT ", 0) == 0) {
+            std::istringstream header(line.substr(9));
+            std::string suffix;
+            if (!(header >> suffix >> size) || !connection.readBytes(size, payload)) break;
+            if (std::ostream* file = artifacts.open(suffix)) {
+                *file << payload;
+                artifacts.close(suffix);
+            }
+        }
+        else {
+            break;
+        }
+    }
+    if (line != "END") {
+        *ctx.err << "Error: Bad response from compile server." << std::endl;
+        return CompileStatus::IO_ERROR;
+    }
+    return static_cast<CompileStatus>(status_code);
+}
+
+bool shutdownServer(const std::string& socket_path) {
+    int fd = connectTo(socket_path);
+    if (fd < 0) {
+        std::cerr << "Error: Could not connect to compile server at " << socket_path << std::endl;
+        return false;
+    }
+    Connection connection(fd);
+    std::string line;
+    return connection.writeAll("SHUTDOWN\n") && connection.readLine(line) && line == "END";
+}
+
+#else // _WIN32
+
+// Unix domain sockets aren't available to this build on Windows.
+
+int runServer(const std::string&, unsigned, CacheDirectory*) {
+    std::cerr << "Error: --server is not supported on this platform." << std::endl;
+    return 1;
+}
+
+CompileStatus compileRemote(const std::string&, CompilationContext& ctx) {
+    *ctx.err << "Error: --client is not supported on this platform." << std::endl;
+    return CompileStatus::IO_ERROR;
+}
+
+bool shutdownServer(const std::string&) {
+    std::cerr << "Error: --shutdown is not supported on this platform." << std::endl;
+    return false;
+}
+
+#endif // _WIN32
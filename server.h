@@ -0,0 +1,45 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "compiler.h"
+#include <string>
+
+// A warm compiler process listening on a Unix domain socket. Clients send the
+// source text with a few options and get back the artifacts, the progress log
+// and the diagnostics; the server itself never reads or writes files, other
+// than those in its own --cache-dir.
+//
+// Requests (one per connection, header lines end with '\n'):
+//     COMPILE
+//     NAME <input path>              used to name the artifacts
+//     OPTION output_dir=<dir>        optional, defaults to "output"
+//     OPTION emit=<list>             optional, as --emit; defaults to "asm"
+//     OPTION scanner=<flex|fast>     optional, as --scanner; defaults to "flex"
+//     SOURCE <byte count>            followed by exactly that many bytes
+// or
+//     SHUTDOWN
+//
+// Responses:
+//     STATUS <CompileStatus as int>
+//     LOG <n> / DIAGNOSTICS <n>      stdout / stderr text, in the order printed
+//     ARTIFACT <suffix> <n>          e.g. "ARTIFACT .assembly.vm 120"
+//     END
+// or "ERROR <message>" for a malformed request.
+//
+// A client that leaves the server waiting 10 seconds for its next bytes, or
+// for room to send the response, is disconnected.
+
+// Serves requests on 'socket_path' until a SHUTDOWN request arrives.
+// 'jobs' connections are handled at once (0 = one per hardware thread).
+// With a 'cache', every request is looked up in and stored to it.
+int runServer(const std::string& socket_path, unsigned jobs, CacheDirectory* cache);
+
+// Compiles ctx.input_filename on the server at 'socket_path'. The log and
+// diagnostics go to ctx.out / ctx.err and the artifacts to ctx.output_dir,
+// exactly as compileFile() would.
+CompileStatus compileRemote(const std::string& socket_path, CompilationContext& ctx);
+
+// Asks the server at 'socket_path' to exit once its current requests are done.
+bool shutdownServer(const std::string& socket_path);
+
+#endif // SERVER_H
@@ -0,0 +1,69 @@
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include "arena.h"
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+// Contiguous array for the AST's child lists. The first N elements live inline
+// in the owning node; beyond that the elements move to a bigger array taken from
+// the arena (the old one is simply abandoned, as arena memory always is). Meant
+// for node pointers: elements are copied with memcpy and never destroyed, so T
+// has to be trivially copyable. The vector is never copied or moved either,
+// since its storage may point into itself.
+template <typename T, unsigned N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable<T>::value, "SmallVector elements are memcpy'd");
+
+private:
+    Arena* arena;
+    T* items;
+    unsigned count = 0;
+    unsigned capacity = N;
+    T inlineItems[N];
+
+    void grow() {
+        unsigned newCapacity = capacity * 2;
+        T* grown = static_cast<T*>(arena->allocate(newCapacity * sizeof(T), alignof(T)));
+        std::memcpy(static_cast<void*>(grown), items, count * sizeof(T));
+        items = grown;
+        capacity = newCapacity;
+    }
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = std::reverse_iterator<T*>;
+    using const_reverse_iterator = std::reverse_iterator<const T*>;
+
+    explicit SmallVector(Arena& a) : arena(&a), items(inlineItems) {}
+
+    SmallVector(const SmallVector&) = delete;
+    SmallVector& operator=(const SmallVector&) = delete;
+
+    void push_back(T value) {
+        if (count == capacity) grow();
+        items[count++] = value;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T& operator[](size_t i) { return items[i]; }
+    const T& operator[](size_t i) const { return items[i]; }
+    T& front() { return items[0]; }
+    T& back() { return items[count - 1]; }
+
+    iterator begin() { return items; }
+    iterator end() { return items + count; }
+    const_iterator begin() const { return items; }
+    const_iterator end() const { return items + count; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+};
+
+#endif // SMALL_VECTOR_H
@@ -0,0 +1,85 @@
+#include "source_buffer.h"
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Bytes yy_scan_buffer() needs after the text
+static const size_t PADDING = 2;
+
+SourceBuffer::~SourceBuffer() {
+    release();
+}
+
+void SourceBuffer::release() {
+#ifndef _WIN32
+    if (mapped) munmap(mapped, mappedLength);
+#endif
+    mapped = nullptr;
+    mappedLength = 0;
+    owned.clear();
+    begin = nullptr;
+    length = 0;
+}
+
+void SourceBuffer::assign(std::string_view text) {
+    release();
+    owned.resize(text.size() + PADDING, '\0');
+    if (!text.empty()) std::memcpy(owned.data(), text.data(), text.size());
+    begin = owned.data();
+    length = text.size();
+}
+
+bool SourceBuffer::loadFile(const std::string& path) {
+    release();
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        size_t fileSize = static_cast<size_t>(info.st_size);
+        size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        // Only map when the padding still falls inside the file's last page:
+        // the rest of that page reads as zeros, but touching a page wholly past
+        // EOF would raise SIGBUS.
+        if (fileSize % pageSize != 0 && fileSize % pageSize <= pageSize - PADDING) {
+            // MAP_PRIVATE + PROT_WRITE: flex may write into the buffer while
+            // scanning, and those writes must never reach the file.
+            void* address = mmap(nullptr, fileSize + PADDING, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                close(fd);
+                mapped = static_cast<char*>(address);
+                mappedLength = fileSize + PADDING;
+                begin = mapped;
+                length = fileSize;
+                return true;
+            }
+        }
+    }
+    close(fd);
+#endif
+
+    // Fallback: read the whole file into an owned buffer.
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    std::vector<char> text;
+    char chunk[64 * 1024];
+    size_t n;
+    while ((n = std::fread(chunk, 1, sizeof chunk, file)) > 0) {
+        text.insert(text.end(), chunk, chunk + n);
+    }
+    bool ok = !std::ferror(file);
+    std::fclose(file);
+    if (!ok) return false;
+
+    text.resize(text.size() + PADDING, '\0');
+    owned = std::move(text);
+    begin = owned.data();
+    length = owned.size() - PADDING;
+    return true;
+}
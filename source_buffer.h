@@ -0,0 +1,54 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// A piece of the source text, as carried by STRING_LITERAL tokens.
+// It points into the compilation's SourceBuffer instead of owning a copy, so it
+// is only valid while that buffer lives. line/column are where the token starts.
+struct SourceSpan {
+    const char* text;
+    int length;
+    int line;
+    int column;
+
+    std::string_view view() const { return std::string_view(text, static_cast<size_t>(length)); }
+    std::string str() const { return std::string(text, static_cast<size_t>(length)); }
+};
+
+// The text being compiled, laid out the way flex's yy_scan_buffer() wants it:
+// writable and followed by two NUL bytes, so the scanner works on it in place.
+// Files are memory-mapped when the platform and the file size allow it and
+// read into an owned buffer otherwise.
+class SourceBuffer {
+private:
+    char* mapped = nullptr;     // mmap'ed file (plus the NUL padding), if any
+    size_t mappedLength = 0;
+    std::vector<char> owned;    // fallback storage
+    char* begin = nullptr;
+    size_t length = 0;
+
+    void release();
+
+public:
+    SourceBuffer() = default;
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    // Maps or reads the file; false if it can't be opened or read.
+    bool loadFile(const std::string& path);
+    // Copies text that is already in memory.
+    void assign(std::string_view text);
+
+    // size() bytes of source followed by two NULs
+    char* data() { return begin; }
+    size_t size() const { return length; }
+    bool isMapped() const { return mapped != nullptr; }
+};
+
+#endif // SOURCE_BUFFER_H
@@ -1,7 +1,8 @@
 #include "symbol_table.h"
+#include "trace.h"
 #include <sstream>
 #include <iostream>
-#include <iterator>
+#include <algorithm>
 
 SymbolEntry::SymbolEntry()
     : kind(SymbolKind::UNKNOWN), type(EntryTypeCategory::UNKNOWN_TYPE),
@@ -120,102 +121,155 @@ std::string SymbolEntry::getMangledName() const {
 }
 
 
-SymbolTable::SymbolTable() : currentLevel(-1) {
+SymbolTable::SymbolTable(StringInterner& n) : names(n), slots(64, Slot{ NONE, NONE }) {
     enterScope();
 }
 
+// The interner hands out SymbolIds consecutively from 0, so the id itself
+// spreads keys evenly: as long as there are fewer keys than slots, most land
+// in their home slot, in id order.
+static size_t slotIndex(SymbolId key, size_t mask) {
+    return key & mask;
+}
+
+SymbolTable::Slot* SymbolTable::findSlot(SymbolId key) {
+    size_t mask = slots.size() - 1;
+    for (size_t i = slotIndex(key, mask); ; i = (i + 1) & mask) {
+        if (slots[i].key == key) return &slots[i];
+        if (slots[i].key == NONE) return nullptr;
+    }
+}
+
+// Slots are never freed: once a key has one, it keeps it (with entry NONE
+// while nothing declares the key), which saves deletions from the probe
+// sequences. There are at most as many keys as interned names.
+SymbolTable::Slot& SymbolTable::slotFor(SymbolId key) {
+    if ((slotsUsed + 1) * 2 > slots.size()) grow();
+    size_t mask = slots.size() - 1;
+    size_t i = slotIndex(key, mask);
+    while (slots[i].key != key && slots[i].key != NONE) i = (i + 1) & mask;
+    if (slots[i].key == NONE) {
+        slots[i].key = key;
+        slotsUsed++;
+    }
+    return slots[i];
+}
+
+void SymbolTable::grow() {
+    std::vector<Slot> old(slots.size() * 2, Slot{ NONE, NONE });
+    old.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.key == NONE) continue;
+        size_t i = slotIndex(slot.key, mask);
+        while (slots[i].key != NONE) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
+
 void SymbolTable::enterScope() {
-    scopeStack.emplace_back();
-    currentLevel++;
+    scopeStarts.push_back(entries.size());
+    if (isTracing()) traceInstant("enterScope", "symtab", "level " + std::to_string(getCurrentLevel()));
 }
 
 void SymbolTable::exitScope() {
-    if (!scopeStack.empty()) {
-        scopeStack.pop_back();
-        currentLevel--;
-    }
-    else {
+    if (scopeStarts.empty()) {
         std::cerr << "Error: Attempting to exit non-existent scope." << std::endl;
+        return;
     }
+    if (isTracing()) traceInstant("exitScope", "symtab", "level " + std::to_string(getCurrentLevel()));
+    // Newest first, so each key ends up back at what the scope found.
+    for (size_t i = entries.size(); i-- > scopeStarts.back(); ) {
+        findSlot(entries[i].id)->entry = shadowed[i];
+        entries.pop_back();
+        shadowed.pop_back();
+    }
+    scopeStarts.pop_back();
 }
 
 bool SymbolTable::isGlobalScope() const {
-    return currentLevel == 0;
+    return scopeStarts.size() == 1;
 }
 
 int SymbolTable::getCurrentLevel() const {
-    return currentLevel;
+    return static_cast<int>(scopeStarts.size()) - 1;
 }
 
 // This function supports overloading by using a mangled name as the key for subprograms.
 bool SymbolTable::addSymbol(const SymbolEntry& entry) {
-    if (scopeStack.empty()) {
+    if (scopeStarts.empty()) {
         std::cerr << "Error: No current scope to add symbol '" << entry.name << "'." << std::endl;
         return false;
     }
 
-    Scope& currentScope = scopeStack.back();
-
     // For functions/procedures, use a mangled name as the key to allow overloading.
     // For all other symbols (variables, etc.), use the simple name.
-    std::string key = (entry.kind == SymbolKind::FUNCTION || entry.kind == SymbolKind::PROCEDURE)
-        ? entry.getMangledName()
-        : entry.name;
-
-    // Check if a symbol with this key (be it mangled or simple) already exists.
-    if (currentScope.count(key)) {
-        // This now correctly detects redeclarations of variables with the same name,
-        // or subprograms with the exact same signature.
+    SymbolId key = (entry.kind == SymbolKind::FUNCTION || entry.kind == SymbolKind::PROCEDURE)
+        ? names.intern(entry.getMangledName())
+        : names.intern(entry.name);
+
+    // A key already declared in this scope is a redeclaration of a variable,
+    // or a subprogram with the exact same signature.
+    Slot& slot = slotFor(key);
+    if (slot.entry != NONE && slot.entry >= scopeStarts.back()) {
         return false;
     }
 
-    // Add the entry to the map using the unique key.
-    currentScope[key] = entry;
+    entries.push_back(entry);
+    entries.back().id = key;
+    shadowed.push_back(slot.entry);
+    slot.entry = static_cast<uint32_t>(entries.size() - 1);
+    symbolsAdded++;
     return true;
 }
 
-SymbolEntry* SymbolTable::lookupSymbol(const std::string& name) {
-    if (scopeStack.empty()) return nullptr;
-    // NOTE: This function is now only suitable for looking up non-overloaded symbols like variables.
-    // The SemanticAnalyzer will need a more advanced way to look up subprograms.
-    for (auto list_iter = std::prev(scopeStack.end()); ; /* decrement inside */) {
-        Scope& scope = *list_iter; // Non-const reference
-        auto foundEntry = scope.find(name);
-        if (foundEntry != scope.end()) {
-            return &(foundEntry->second);
-        }
-        if (list_iter == scopeStack.begin()) { // Checked the global scope
-            break;
-        }
-        --list_iter; // Move to previous scope
-    }
-    return nullptr; // Not found in any scope
+SymbolEntry* SymbolTable::lookupSymbol(SymbolId id) {
+    Slot* slot = findSlot(id);
+    return slot && slot->entry != NONE ? &entries[slot->entry] : nullptr;
 }
 
-SymbolEntry* SymbolTable::lookupSymbolInCurrentScope(const std::string& name) {
-    if (scopeStack.empty()) {
+SymbolEntry* SymbolTable::lookupSymbolInCurrentScope(SymbolId id) {
+    Slot* slot = findSlot(id);
+    if (!slot || slot->entry == NONE || scopeStarts.empty() || slot->entry < scopeStarts.back()) {
         return nullptr;
     }
-    Scope& currentScope = scopeStack.back();
-    auto foundEntry = currentScope.find(name);
-    if (foundEntry != currentScope.end()) {
-        return &(foundEntry->second);
+    return &entries[slot->entry];
+}
+
+// A name that was never interned can't be a key in any scope.
+SymbolEntry* SymbolTable::lookupSymbol(const std::string& name) {
+    SymbolId id;
+    return names.find(name, id) ? lookupSymbol(id) : nullptr;
+}
+
+SymbolEntry* SymbolTable::lookupSymbolInCurrentScope(const std::string& name) {
+    SymbolId id;
+    return names.find(name, id) ? lookupSymbolInCurrentScope(id) : nullptr;
+}
+
+std::vector<const SymbolEntry*> SymbolTable::globalSymbols() const {
+    std::vector<const SymbolEntry*> globals;
+    if (scopeStarts.empty()) return globals;
+    size_t end = scopeStarts.size() > 1 ? scopeStarts[1] : entries.size();
+    for (size_t i = 0; i < end; i++) {
+        globals.push_back(&entries[i]);
     }
-    return nullptr;
+    std::sort(globals.begin(), globals.end(),
+        [](const SymbolEntry* a, const SymbolEntry* b) { return a->id < b->id; });
+    return globals;
 }
 
 void SymbolTable::printCurrentScope() const {
-    if (scopeStack.empty()) {
+    if (scopeStarts.empty()) {
         std::cout << "Symbol Table: No active scope." << std::endl;
         return;
     }
-    std::cout << "--- Current Scope (Level " << currentLevel << ") ---" << std::endl;
-    const Scope& currentScope = scopeStack.back();
-    for (const auto& pair : currentScope) {
-        std::cout << "  " << pair.second.toString() << std::endl;
+    std::cout << "--- Current Scope (Level " << getCurrentLevel() << ") ---" << std::endl;
+    for (size_t i = scopeStarts.back(); i < entries.size(); i++) {
+        std::cout << "  " << entries[i].toString() << std::endl;
     }
-    if (currentScope.empty()) {
+    if (scopeStarts.back() == entries.size()) {
         std::cout << "  (empty)" << std::endl;
     }
     std::cout << "---------------------------" << std::endl;
-}
\ No newline at end of file
+}
@@ -2,15 +2,17 @@
 #define SYMBOL_TABLE_H
 
 #include "semantic_types.h"
+#include "interner.h"
 #include <string>
 #include <vector>
-#include <map>
-#include <list>
+#include <cstdint>
+#include <deque>
 #include <utility> // For std::pair
 
 class SymbolEntry {
 public:
     std::string name;
+    SymbolId id = 0; // interned key: the mangled name for subprograms, 'name' otherwise
     SymbolKind kind;
     EntryTypeCategory type;
     int offset;
@@ -39,14 +41,35 @@ public:
     std::string getMangledName() const;
 };
 
+// All scopes share one open-addressing hash table from key to the innermost
+// entry for it; each entry links to the one it shadows. Only the current scope
+// ever adds entries, so they are kept on a stack in declaration order, which
+// doubles as the scopes' undo log: exitScope() pops what the scope added and
+// puts back what each entry shadowed. Lookups cost one probe sequence however
+// deeply scopes nest.
 class SymbolTable {
 private:
-    using Scope = std::map<std::string, SymbolEntry>;
-    std::list<Scope> scopeStack;
-    int currentLevel;
+    static const uint32_t NONE = UINT32_MAX;
+    struct Slot {
+        SymbolId key;   // NONE: free
+        uint32_t entry; // innermost entry for 'key', NONE while out of scope
+    };
+    StringInterner& names;
+    // deque: entries stay put as the stack grows, so pointers to them hold
+    // until their scope is exited
+    std::deque<SymbolEntry> entries;
+    std::vector<uint32_t> shadowed; // per entry: the entry with its key it hides, or NONE
+    std::vector<size_t> scopeStarts; // per scope, outermost first: its first entry
+    std::vector<Slot> slots; // power-of-two size, at most half used
+    size_t slotsUsed = 0;
+    size_t symbolsAdded = 0;
+
+    Slot& slotFor(SymbolId key);
+    Slot* findSlot(SymbolId key);
+    void grow();
 
 public:
-    SymbolTable();
+    explicit SymbolTable(StringInterner& names);
 
     void enterScope();
     void exitScope();
@@ -54,10 +77,18 @@ public:
     int getCurrentLevel() const;
 
     bool addSymbol(const SymbolEntry& entry);
+    SymbolEntry* lookupSymbol(SymbolId id);
+    SymbolEntry* lookupSymbolInCurrentScope(SymbolId id);
+    // By spelling, for keys that are built rather than scanned (mangled names)
     SymbolEntry* lookupSymbol(const std::string& name);
     SymbolEntry* lookupSymbolInCurrentScope(const std::string& name);
 
+    // Entries of the outermost scope, ordered by key
+    std::vector<const SymbolEntry*> globalSymbols() const;
+
     void printCurrentScope() const;
+    // Total number of symbols added across all scopes, for --time-report
+    size_t getSymbolCount() const { return symbolsAdded; }
 };
 
 #endif // SYMBOL_TABLE_H
\ No newline at end of file
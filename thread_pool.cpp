@@ -0,0 +1,100 @@
+#include "thread_pool.h"
+
+// The pool and worker index owning the current thread, so tasks submitted from
+// inside a running task go to that worker's own deque.
+static thread_local const WorkStealingPool* current_pool = nullptr;
+static thread_local size_t current_worker = 0;
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount) {
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 1;
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    size_t target;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        target = (current_pool == this) ? current_worker : nextWorker++ % workers.size();
+        ++unfinished;
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers[target]->mutex);
+        workers[target]->tasks.push_back(std::move(task));
+    }
+    {
+        // Only count the task once it is actually in a deque (see workerLoop).
+        std::lock_guard<std::mutex> lock(stateMutex);
+        ++queued;
+    }
+    workAvailable.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this] { return unfinished == 0; });
+}
+
+bool WorkStealingPool::takeTask(size_t index, Task& task) {
+    // Own deque first, newest task (LIFO keeps its data warm in cache)...
+    {
+        Worker& own = *workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    // ...then steal the oldest task of another worker.
+    for (size_t i = 1; i < workers.size(); ++i) {
+        Worker& victim = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(size_t index) {
+    current_pool = this;
+    current_worker = index;
+    for (;;) {
+        {
+            // Reserve one queued task. Because 'queued' is only raised after the
+            // push, a reserved task is always sitting in some deque.
+            std::unique_lock<std::mutex> lock(stateMutex);
+            workAvailable.wait(lock, [this] { return queued > 0 || stopping; });
+            if (queued == 0) return; // stopping and drained
+            --queued;
+        }
+        Task task;
+        while (!takeTask(index, task)) {
+            std::this_thread::yield();
+        }
+        task();
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--unfinished == 0) allDone.notify_all();
+        }
+    }
+}
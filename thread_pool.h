@@ -0,0 +1,54 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <functional>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+
+// A small work-stealing thread pool. Every worker owns a deque: it takes work
+// from the back of its own deque and, when that runs dry, steals from the front
+// of the others. Long compilations on one worker therefore don't leave the
+// rest idle while files are still queued behind them.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    // threadCount == 0 means one worker per hardware thread.
+    explicit WorkStealingPool(unsigned threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Task task);
+    // Blocks until every submitted task has finished.
+    void wait();
+
+    size_t size() const { return workers.size(); }
+
+private:
+    struct Worker {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    size_t queued = 0;      // tasks sitting in some deque
+    size_t unfinished = 0;  // tasks submitted but not yet completed
+    size_t nextWorker = 0;  // round-robin target for external submissions
+    bool stopping = false;
+
+    void workerLoop(size_t index);
+    bool takeTask(size_t index, Task& task);
+};
+
+#endif // THREAD_POOL_H
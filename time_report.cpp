@@ -0,0 +1,171 @@
+#include "time_report.h"
+#include <ostream>
+#include <iomanip>
+#include <ctime>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+// The phases in the order compileFile() runs them
+static const char* const STANDARD_PHASES[] = {
+    "lexing", "parsing", "ast dump", "semantic analysis", "code generation", "output writing"
+};
+
+// CPU time consumed by the calling thread, in milliseconds.
+static double threadCpuMs() {
+#ifndef _WIN32
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+#else
+    // No portable per-thread clock here; the process clock is close enough
+    // outside of batch mode.
+    return std::clock() * 1000.0 / CLOCKS_PER_SEC;
+#endif
+}
+
+long peakRssKb() {
+#ifndef _WIN32
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+// --- TimeReport ---
+
+TimeReport::TimeReport() {
+    for (const char* name : STANDARD_PHASES) {
+        phases.emplace_back();
+        phases.back().name = name;
+    }
+}
+
+PhaseStats& TimeReport::phase(const std::string& name) {
+    for (PhaseStats& stats : phases) {
+        if (stats.name == name) return stats;
+    }
+    phases.emplace_back();
+    phases.back().name = name;
+    return phases.back();
+}
+
+std::vector<PhaseStats> TimeReport::ranPhases() const {
+    std::vector<PhaseStats> result;
+    for (const PhaseStats& stats : phases) {
+        if (stats.runs > 0) result.push_back(stats);
+    }
+    return result;
+}
+
+void TimeReport::printTable(std::ostream& out, const std::string& file) const {
+    std::streamsize oldPrecision = out.precision();
+    out << "--- Time Report: " << file << " ---" << std::endl;
+    out << std::left << std::setw(20) << "Phase" << std::right
+        << std::setw(12) << "Wall (ms)" << std::setw(12) << "CPU (ms)"
+        << std::setw(14) << "Peak RSS +KB" << "  Objects" << std::endl;
+
+    auto printRow = [&out](const PhaseStats& stats) {
+        out << std::left << std::setw(20) << stats.name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(12) << stats.wall_ms << std::setw(12) << stats.cpu_ms
+            << std::setw(14) << stats.peak_rss_delta_kb;
+        if (!stats.object_kind.empty()) out << "  " << stats.objects << " " << stats.object_kind;
+        out << std::endl;
+    };
+
+    PhaseStats total;
+    total.name = "total";
+    for (const PhaseStats& stats : ranPhases()) {
+        printRow(stats);
+        total.wall_ms += stats.wall_ms;
+        total.cpu_ms += stats.cpu_ms;
+        total.peak_rss_delta_kb += stats.peak_rss_delta_kb;
+    }
+    printRow(total);
+    out << "Peak RSS: " << peakRssKb() << " KB" << std::endl;
+    out.unsetf(std::ios::floatfield);
+    out.precision(oldPrecision);
+}
+
+static void writeJsonString(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (char c : s) {
+        switch (c) {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c)
+                    << std::dec << std::setfill(' ');
+            }
+            else out << c;
+        }
+    }
+    out << '"';
+}
+
+void TimeReport::printJson(std::ostream& out, const std::string& file) const {
+    std::streamsize oldPrecision = out.precision();
+    out << "{\"file\":";
+    writeJsonString(out, file);
+    out << ",\"phases\":[";
+    bool first = true;
+    for (const PhaseStats& stats : ranPhases()) {
+        if (!first) out << ",";
+        first = false;
+        out << "{\"name\":";
+        writeJsonString(out, stats.name);
+        out << std::fixed << std::setprecision(3)
+            << ",\"runs\":" << stats.runs
+            << ",\"wall_ms\":" << stats.wall_ms
+            << ",\"cpu_ms\":" << stats.cpu_ms
+            << ",\"peak_rss_delta_kb\":" << stats.peak_rss_delta_kb
+            << ",\"objects\":" << stats.objects
+            << ",\"object_kind\":";
+        writeJsonString(out, stats.object_kind);
+        out << "}";
+    }
+    out << "],\"peak_rss_kb\":" << peakRssKb() << "}" << std::endl;
+    out.unsetf(std::ios::floatfield);
+    out.precision(oldPrecision);
+}
+
+// --- PhaseTimer ---
+
+PhaseTimer::PhaseTimer(TimeReport* report, const char* name) : report(report), name(name) {
+    if (!report) return;
+    rssStart = peakRssKb();
+    cpuStart = threadCpuMs();
+    wallStart = std::chrono::steady_clock::now();
+}
+
+PhaseTimer::~PhaseTimer() {
+    if (!report) return;
+    std::chrono::duration<double, std::milli> wall = std::chrono::steady_clock::now() - wallStart;
+    double cpu = threadCpuMs() - cpuStart;
+
+    PhaseStats& stats = report->phase(name);
+    stats.runs++;
+    stats.wall_ms += wall.count();
+    stats.cpu_ms += cpu;
+    stats.peak_rss_delta_kb += peakRssKb() - rssStart;
+    if (objectKind) {
+        stats.objects += objects;
+        stats.object_kind = objectKind;
+    }
+}
+
+void PhaseTimer::setObjects(size_t count, const char* kind) {
+    objects = count;
+    objectKind = kind;
+}
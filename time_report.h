@@ -0,0 +1,63 @@
+#ifndef TIME_REPORT_H
+#define TIME_REPORT_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iosfwd>
+
+// What one compiler phase cost, for --time-report.
+struct PhaseStats {
+    std::string name;
+    int runs = 0;                // how often the phase was entered (output writing runs per artifact)
+    double wall_ms = 0;
+    double cpu_ms = 0;           // CPU time of the compiling thread
+    long peak_rss_delta_kb = 0;  // growth of the process's peak RSS while the phase ran
+    size_t objects = 0;          // what the phase produced, counted in 'object_kind'
+    std::string object_kind;
+};
+
+// Per-compilation collection of PhaseStats, in pipeline order.
+class TimeReport {
+private:
+    std::vector<PhaseStats> phases;
+
+public:
+    TimeReport();
+
+    // Entry for 'name'; unknown names are appended after the standard phases.
+    PhaseStats& phase(const std::string& name);
+    // Phases that actually ran
+    std::vector<PhaseStats> ranPhases() const;
+
+    void printTable(std::ostream& out, const std::string& file) const;
+    // One JSON object on a single line, so several reports form JSON Lines.
+    void printJson(std::ostream& out, const std::string& file) const;
+};
+
+// Adds the cost of the enclosing scope to report->phase(name).
+// With a null report it measures nothing.
+class PhaseTimer {
+private:
+    TimeReport* report;
+    const char* name;
+    std::chrono::steady_clock::time_point wallStart;
+    double cpuStart = 0;
+    long rssStart = 0;
+    size_t objects = 0;
+    const char* objectKind = nullptr;
+
+public:
+    PhaseTimer(TimeReport* report, const char* name);
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    void setObjects(size_t count, const char* kind);
+};
+
+// Peak resident set size of the process so far, in KB (0 where unavailable).
+long peakRssKb();
+
+#endif // TIME_REPORT_H
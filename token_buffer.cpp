@@ -0,0 +1,43 @@
+#include "token_buffer.h"
+#include "lexer.h"
+#include "interner.h"
+#include <iostream>
+
+TokenBuffer::TokenBuffer() : cursor(0), endLine(1), endColumn(1) {}
+
+void TokenBuffer::append(int kind, int line, int column, const YYSTYPE& value) {
+    tokens.push_back(Token{ kind, line, column, value });
+}
+
+void TokenBuffer::finish(int line, int column) {
+    endLine = line;
+    endColumn = column;
+    cursor = 0;
+}
+
+int TokenBuffer::next(YYSTYPE& lval, int& line, int& column) {
+    if (cursor >= tokens.size()) {
+        line = endLine;
+        column = endColumn;
+        return 0;
+    }
+    const Token& tok = tokens[cursor++];
+    line = tok.line;
+    column = tok.column;
+    lval = tok.value;
+    return tok.kind;
+}
+
+void TokenBuffer::dump(std::ostream& out, const StringInterner& names) const {
+    out << "--- Token Stream ---" << std::endl;
+    for (const Token& tok : tokens) {
+        out << "Token: " << token_to_string(tok.kind, tok.value)
+            << " (ID: " << tok.kind << ")"
+            << " at (L:" << tok.line << ", C:" << tok.column << ")";
+        if (tok.kind == IDENT) out << " - Value: " << names.name(tok.value.ident.id);
+        if (tok.kind == NUM) out << " - Value: " << tok.value.int_token.value;
+        if (tok.kind == REAL_LITERAL) out << " - Value: " << tok.value.real_token.value;
+        if (tok.kind == STRING_LITERAL) out << " - Value: \"" << tok.value.str_span.view() << "\"";
+        out << std::endl;
+    }
+}
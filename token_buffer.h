@@ -0,0 +1,44 @@
+#ifndef TOKEN_BUFFER_H
+#define TOKEN_BUFFER_H
+
+#include "ast.h"
+#include "parser.h"
+#include <vector>
+#include <iosfwd>
+
+class StringInterner;
+
+// A single scanned token. 'line'/'column' are the scanner position right after
+// the token was matched, which is what the parser actions used to see in lin/col.
+struct Token {
+    int kind;
+    int line;
+    int column;
+    YYSTYPE value;
+};
+
+// The token stream of one compilation. It is filled once by the scanner and then
+// replayed to the parser, so the source is never lexed twice.
+class TokenBuffer {
+private:
+    std::vector<Token> tokens;
+    size_t cursor;
+    int endLine;
+    int endColumn;
+
+public:
+    TokenBuffer();
+
+    // Called by the scanner for every token, then once at end of input.
+    void append(int kind, int line, int column, const YYSTYPE& value);
+    void finish(int line, int column);
+
+    // Hands out the next token to the parser (0 at end of input) together with
+    // the scanner position it was scanned at.
+    int next(YYSTYPE& lval, int& line, int& column);
+
+    void dump(std::ostream& out, const StringInterner& names) const;
+    size_t size() const { return tokens.size(); }
+};
+
+#endif // TOKEN_BUFFER_H
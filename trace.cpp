@@ -0,0 +1,109 @@
+#include "trace.h"
+#include <fstream>
+#include <iomanip>
+
+// Recorder the trace calls on this thread report to (see TraceActivation)
+static thread_local TraceRecorder* active_recorder = nullptr;
+
+// --- TraceRecorder ---
+
+TraceRecorder::TraceRecorder() : origin(std::chrono::steady_clock::now()) {}
+
+double TraceRecorder::now() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+unsigned TraceRecorder::threadIdLocked() {
+    auto inserted = threadIds.emplace(std::this_thread::get_id(), static_cast<unsigned>(threadIds.size() + 1));
+    return inserted.first->second;
+}
+
+void TraceRecorder::addSpan(const char* name, const char* category, double start_us, double end_us, std::string detail) {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(Event{ name, category, 'X', start_us, end_us - start_us, threadIdLocked(), std::move(detail) });
+}
+
+void TraceRecorder::addInstant(const char* name, const char* category, std::string detail) {
+    double ts = now();
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(Event{ name, category, 'i', ts, 0, threadIdLocked(), std::move(detail) });
+}
+
+static void writeJsonString(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (char c : s) {
+        switch (c) {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+            else out << c;
+        }
+    }
+    out << '"';
+}
+
+bool TraceRecorder::writeJson(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& e = events[i];
+        out << "{\"name\":";
+        writeJsonString(out, e.name);
+        out << ",\"cat\":\"" << e.category << "\",\"ph\":\"" << e.phase << "\",\"ts\":" << e.start_us;
+        if (e.phase == 'X') out << ",\"dur\":" << e.duration_us;
+        else out << ",\"s\":\"t\"";
+        out << ",\"pid\":1,\"tid\":" << e.thread;
+        if (!e.detail.empty()) {
+            out << ",\"args\":{\"detail\":";
+            writeJsonString(out, e.detail);
+            out << "}";
+        }
+        out << "}" << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    out << "],\"displayTimeUnit\":\"ms\"}" << std::endl;
+    return static_cast<bool>(out);
+}
+
+// --- TraceActivation ---
+
+TraceActivation::TraceActivation(TraceRecorder* recorder) : previous(active_recorder) {
+    active_recorder = recorder;
+}
+
+TraceActivation::~TraceActivation() {
+    active_recorder = previous;
+}
+
+// --- TraceScope ---
+
+TraceScope::TraceScope(const char* name, const char* category)
+    : recorder(active_recorder), name(name), category(category) {
+    if (recorder) start = recorder->now();
+}
+
+TraceScope::TraceScope(const char* name, const char* category, const std::string& detail)
+    : recorder(active_recorder), name(name), category(category) {
+    if (recorder) {
+        this->detail = detail;
+        start = recorder->now();
+    }
+}
+
+TraceScope::~TraceScope() {
+    if (recorder) recorder->addSpan(name, category, start, recorder->now(), std::move(detail));
+}
+
+bool isTracing() {
+    return active_recorder != nullptr;
+}
+
+void traceInstant(const char* name, const char* category, const std::string& detail) {
+    if (active_recorder) active_recorder->addInstant(name, category, detail);
+}
@@ -0,0 +1,85 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+// Collects Chrome trace events (the JSON format read by chrome://tracing and
+// Perfetto) for --trace. One recorder may be shared by every compilation of a
+// batch; each worker thread shows up as its own track.
+class TraceRecorder {
+private:
+    struct Event {
+        std::string name;
+        const char* category;
+        char phase;        // 'X' = complete span, 'i' = instant
+        double start_us;
+        double duration_us;
+        unsigned thread;
+        std::string detail; // shown as args.detail
+    };
+
+    std::mutex mutex;
+    std::vector<Event> events;
+    std::map<std::thread::id, unsigned> threadIds;
+    std::chrono::steady_clock::time_point origin;
+
+    unsigned threadIdLocked();
+
+public:
+    TraceRecorder();
+
+    // Microseconds since the recorder was created
+    double now() const;
+
+    void addSpan(const char* name, const char* category, double start_us, double end_us, std::string detail);
+    void addInstant(const char* name, const char* category, std::string detail);
+
+    // Writes {"traceEvents": [...]}; false if the file can't be written.
+    bool writeJson(const std::string& path);
+};
+
+// Makes 'recorder' the target of the trace calls below on this thread for as
+// long as the activation lives, so the analyzers need no extra plumbing.
+// A null recorder switches tracing off.
+class TraceActivation {
+private:
+    TraceRecorder* previous;
+
+public:
+    explicit TraceActivation(TraceRecorder* recorder);
+    ~TraceActivation();
+
+    TraceActivation(const TraceActivation&) = delete;
+    TraceActivation& operator=(const TraceActivation&) = delete;
+};
+
+// Records the enclosing scope as one span when tracing is active on this thread.
+class TraceScope {
+private:
+    TraceRecorder* recorder;
+    const char* name;
+    const char* category;
+    std::string detail;
+    double start = 0;
+
+public:
+    TraceScope(const char* name, const char* category);
+    TraceScope(const char* name, const char* category, const std::string& detail);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+// Whether trace calls on this thread are recorded, to skip building details.
+bool isTracing();
+
+// Records a point event when tracing is active on this thread.
+void traceInstant(const char* name, const char* category, const std::string& detail);
+
+#endif // TRACE_H
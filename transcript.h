@@ -0,0 +1,53 @@
+#ifndef TRANSCRIPT_H
+#define TRANSCRIPT_H
+
+#include <streambuf>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// What a compilation printed, as one ordered list of chunks; 'first' is true
+// for the diagnostics (ctx.err) and false for the progress log (ctx.out), so
+// the interleaving can be replayed.
+using Transcript = std::vector<std::pair<bool, std::string>>;
+
+// Records what is written through it into a Transcript, and passes it on to
+// 'forward' as well if one is given.
+class TranscriptBuf : public std::streambuf {
+private:
+    Transcript& chunks;
+    bool is_diagnostic;
+    std::ostream* forward;
+
+    void append(const char* s, std::streamsize n) {
+        if (chunks.empty() || chunks.back().first != is_diagnostic) {
+            chunks.emplace_back(is_diagnostic, std::string());
+        }
+        chunks.back().second.append(s, static_cast<size_t>(n));
+        if (forward) forward->write(s, n);
+    }
+
+protected:
+    int overflow(int ch) override {
+        if (ch != traits_type::eof()) {
+            char c = static_cast<char>(ch);
+            append(&c, 1);
+        }
+        return ch;
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        append(s, n);
+        return n;
+    }
+    int sync() override {
+        if (forward) forward->flush();
+        return 0;
+    }
+
+public:
+    TranscriptBuf(Transcript& target, bool diagnostic, std::ostream* forwardTo = nullptr)
+        : chunks(target), is_diagnostic(diagnostic), forward(forwardTo) {}
+};
+
+#endif // TRANSCRIPT_H